@@ -0,0 +1,131 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <vector>
+
+// Resettable arena for temporaries of one loop iteration, e.g. one staked item of a claim.
+//
+// The WASM allocator never reuses freed memory within an action, so a temporary that is
+// allocated per item raises peak memory with every item. Containers that take arena::allocator
+// allocate from the arena while an arena::scope is open and fall back to the heap otherwise.
+// Closing a scope hands its memory back to the arena, the next item reuses the same blocks, so
+// peak memory depends on the largest item and not on the number of items.
+//
+// Everything allocated in a scope has to be destroyed before the scope closes.
+namespace arena
+{
+    static constexpr size_t block_size = 4096;
+
+    struct block
+    {
+        char*  data;
+        size_t size;
+    };
+
+    struct state
+    {
+        std::vector<block> blocks; // allocated once, reused by every scope
+        size_t current = 0;        // block allocations are taken from
+        size_t used    = 0;        // bytes used of the current block
+        uint32_t depth = 0;        // open scopes
+        size_t reserved = 0;       // bytes of all blocks, the arena's share of peak memory
+    };
+
+    // every action runs in a fresh WASM instance, so the arena starts empty
+    inline state& get_state()
+    {
+        static state s;
+        return s;
+    }
+
+    inline bool owns(const void* ptr)
+    {
+        for(const block& b : get_state().blocks)
+            if(ptr >= static_cast<const void*>(b.data) && ptr < static_cast<const void*>(b.data + b.size))
+                return true;
+        return false;
+    }
+
+    inline void* allocate(const size_t& bytes, const size_t& alignment)
+    {
+        state& s = get_state();
+        if(s.depth == 0)
+            return ::operator new(bytes);
+
+        for(;; ++s.current, s.used = 0)
+        {
+            if(s.current == s.blocks.size())
+            {
+                const size_t size = bytes + alignment > block_size ? bytes + alignment : block_size;
+                s.blocks.push_back({static_cast<char*>(::operator new(size)), size});
+                s.reserved += size;
+            }
+
+            block& b = s.blocks[s.current];
+            const size_t start = (reinterpret_cast<uintptr_t>(b.data) + s.used + alignment - 1) / alignment * alignment
+                - reinterpret_cast<uintptr_t>(b.data);
+            if(start + bytes <= b.size)
+            {
+                s.used = start + bytes;
+                return b.data + start;
+            }
+        }
+    }
+
+    inline void deallocate(void* ptr)
+    {
+        // arena memory is released all at once when its scope closes
+        if(!owns(ptr))
+            ::operator delete(ptr);
+    }
+
+    // memory allocated after a scope opened is reused once it closes, scopes nest
+    class scope
+    {
+      public:
+        scope()
+        {
+            state& s = get_state();
+            ++s.depth;
+            mark_block = s.current;
+            mark_used  = s.used;
+        }
+
+        ~scope()
+        {
+            state& s = get_state();
+            --s.depth;
+            s.current = mark_block;
+            s.used    = mark_used;
+        }
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+      private:
+        size_t mark_block;
+        size_t mark_used;
+    };
+
+    template <typename T>
+    struct allocator
+    {
+        using value_type = T;
+
+        allocator() = default;
+        template <typename U>
+        allocator(const allocator<U>&) {}
+
+        T* allocate(size_t n) { return static_cast<T*>(arena::allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T* ptr, size_t) { arena::deallocate(ptr); }
+
+        template <typename U>
+        bool operator==(const allocator<U>&) const { return true; }
+        template <typename U>
+        bool operator!=(const allocator<U>&) const { return false; }
+    };
+
+    typedef std::basic_string<char, std::char_traits<char>, allocator<char>> string;
+}
@@ -117,6 +117,32 @@ namespace atomicassets
         return assets_t(ATOMICASSETS_ACCOUNT, acc.value);
     }
 
+    // Rows of asset_ids in ascending id order. The ids are sorted, an id that directly follows the
+    // previous one is reached by stepping the iterator, any other id is looked up with find, so every
+    // row is loaded once. Fails on the first id that is not in the table. Assets is assets_t or a
+    // wrapper of it with the same interface.
+    template <typename Assets>
+    std::vector <typename Assets::const_iterator> find_assets(const Assets &assets, std::vector <uint64_t> asset_ids) {
+        std::sort(asset_ids.begin(), asset_ids.end());
+
+        std::vector <typename Assets::const_iterator> rows;
+        rows.reserve(asset_ids.size());
+        auto assets_itr = assets.end();
+        for (const uint64_t &asset_id : asset_ids) {
+            if (assets_itr != assets.end() && assets_itr->asset_id + 1 == asset_id) {
+                ++assets_itr;
+            } else {
+                assets_itr = assets.find(asset_id);
+            }
+
+            if (assets_itr == assets.end() || assets_itr->asset_id != asset_id) {
+                check(false, "Could not find asset [" + std::to_string(asset_id) + "]");
+            }
+            rows.push_back(assets_itr);
+        }
+        return rows;
+    }
+
     schemas_t get_schemas(name collection_name) {
         return schemas_t(ATOMICASSETS_ACCOUNT, collection_name.value);
     }
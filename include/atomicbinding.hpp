@@ -0,0 +1,487 @@
+#pragma once
+#include <cstring>
+#include <optional>
+#include "arena.hpp"
+#include "atomicdata.hpp"
+
+using namespace eosio;
+
+
+// Typed bindings of atomicassets attributes.
+//
+// A binding struct lists the attributes it uses in a static constexpr fields()
+// tuple of atomicdata::bind("name", &T::member) entries, every bound member is a
+// std::optional. make_bound_layout resolves a schema format against the binding
+// once and checks the wire type of every bound attribute. decode_bound then reads
+// the struct straight from serialized data, without ATTRIBUTE_MAP or variants.
+//
+// Attributes that are not bound are skipped, or copied undecoded into a
+// RAW_ATTRIBUTES member named `others` if the binding has one, so that bound_map
+// can write the struct back as complete attribute map. others takes its memory
+// from the open arena::scope, a binding decoded per item does not grow the heap.
+// A binding that is written back but has no `others` sets
+// `static constexpr bool reject_unbound = true` instead, then decoding fails on
+// attributes it would lose.
+//
+// Only the attribute types of bound members are instantiated. Nothing references
+// the generic (de)serializer or ATOMIC_ATTRIBUTE visitors, and without `others`
+// base58 is left out of the wasm as well.
+namespace atomicdata {
+
+    template <typename T, typename V>
+    struct bound_field {
+        const char *name;
+        std::optional <V> T::*member;
+    };
+
+    template <typename T, typename V>
+    constexpr bound_field <T, V> bind(const char *name, std::optional <V> T::*member) {
+        return {name, member};
+    }
+
+
+    enum class wire_kind : uint8_t {
+        SIGNED,   // zigzag varint
+        UNSIGNED, // varint
+        FIXED,    // little endian, `bytes` wide
+        FLOAT,
+        DOUBLE,
+        STRING,
+        IPFS,
+        BYTE
+    };
+
+    struct wire_type {
+        wire_kind kind;
+        uint8_t bytes;
+        bool array;
+    };
+
+    wire_type parse_wire_type(const std::string &type) {
+        const bool array = type.find("[]", type.length() - 2) == type.length() - 2;
+        const std::string base_type = array ? type.substr(0, type.length() - 2) : type;
+
+        if (base_type == "int8") return {wire_kind::SIGNED, 1, array};
+        if (base_type == "int16") return {wire_kind::SIGNED, 2, array};
+        if (base_type == "int32") return {wire_kind::SIGNED, 4, array};
+        if (base_type == "int64") return {wire_kind::SIGNED, 8, array};
+        if (base_type == "uint8") return {wire_kind::UNSIGNED, 1, array};
+        if (base_type == "uint16") return {wire_kind::UNSIGNED, 2, array};
+        if (base_type == "uint32") return {wire_kind::UNSIGNED, 4, array};
+        if (base_type == "uint64") return {wire_kind::UNSIGNED, 8, array};
+        if (base_type == "fixed8") return {wire_kind::FIXED, 1, array};
+        if (base_type == "fixed16") return {wire_kind::FIXED, 2, array};
+        if (base_type == "fixed32") return {wire_kind::FIXED, 4, array};
+        if (base_type == "fixed64") return {wire_kind::FIXED, 8, array};
+        if (base_type == "float") return {wire_kind::FLOAT, 4, array};
+        if (base_type == "double") return {wire_kind::DOUBLE, 8, array};
+        if (base_type == "string" || base_type == "image") return {wire_kind::STRING, 0, array};
+        if (base_type == "ipfs") return {wire_kind::IPFS, 0, array};
+        if (base_type == "bool" || base_type == "byte") return {wire_kind::BYTE, 1, array};
+
+        check(false, "No type could be matched - " + type);
+        return {wire_kind::BYTE, 0, false}; //This point can never be reached because the check above will always throw.
+    }
+
+
+    template <typename V>
+    struct is_vector : std::false_type {};
+
+    template <typename V>
+    struct is_vector <std::vector <V>> : std::true_type {};
+
+    template <typename V>
+    bool accepts_scalar(const wire_type &wire) {
+        if constexpr (std::is_same_v <V, float>) {
+            return wire.kind == wire_kind::FLOAT;
+        } else if constexpr (std::is_same_v <V, double>) {
+            return wire.kind == wire_kind::DOUBLE;
+        } else if constexpr (std::is_same_v <V, std::string>) {
+            return wire.kind == wire_kind::STRING || wire.kind == wire_kind::IPFS;
+        } else if constexpr (std::is_integral_v <V> && std::is_signed_v <V>) {
+            return wire.kind == wire_kind::SIGNED && wire.bytes == sizeof(V);
+        } else if constexpr (std::is_integral_v <V>) {
+            return ((wire.kind == wire_kind::UNSIGNED || wire.kind == wire_kind::FIXED) && wire.bytes == sizeof(V))
+                || (wire.kind == wire_kind::BYTE && sizeof(V) == 1);
+        } else {
+            return false;
+        }
+    }
+
+    template <typename V>
+    bool accepts(const wire_type &wire) {
+        if constexpr (is_vector <V>::value) {
+            return wire.array && accepts_scalar <typename V::value_type>(wire);
+        } else {
+            return !wire.array && accepts_scalar <V>(wire);
+        }
+    }
+
+
+    template <typename V>
+    V read_scalar(const wire_type &wire, std::vector <uint8_t>::const_iterator &itr) {
+        if constexpr (std::is_same_v <V, float> || std::is_same_v <V, double>) {
+            uint8_t array_repr[sizeof(V)];
+            for (uint8_t &i : array_repr) {
+                i = *itr;
+                itr++;
+            }
+            V value;
+            memcpy(&value, array_repr, sizeof(V));
+            return value;
+        } else if constexpr (std::is_same_v <V, std::string>) {
+            uint64_t length = unsignedFromVarintBytes(itr);
+            if (wire.kind == wire_kind::IPFS) {
+                std::vector <uint8_t> byte_array(itr, itr + length);
+                itr += length;
+                return EncodeBase58(byte_array);
+            }
+            std::string text(itr, itr + length);
+            itr += length;
+            return text;
+        } else if constexpr (std::is_signed_v <V>) {
+            return (V) zigzagDecode(unsignedFromVarintBytes(itr));
+        } else {
+            if (wire.kind == wire_kind::FIXED) {
+                return (V) unsignedFromIntBytes(itr, wire.bytes);
+            } else if (wire.kind == wire_kind::BYTE) {
+                uint8_t next_byte = *itr;
+                itr++;
+                return next_byte;
+            }
+            return (V) unsignedFromVarintBytes(itr);
+        }
+    }
+
+    template <typename V>
+    V read_value(const wire_type &wire, std::vector <uint8_t>::const_iterator &itr) {
+        if constexpr (is_vector <V>::value) {
+            uint64_t array_length = unsignedFromVarintBytes(itr);
+            V vec = {};
+            vec.reserve(array_length);
+            for (uint64_t i = 0; i < array_length; i++) {
+                vec.push_back(read_scalar <typename V::value_type>(wire, itr));
+            }
+            return vec;
+        } else {
+            return read_scalar <V>(wire, itr);
+        }
+    }
+
+    void skip_scalar(const wire_type &wire, std::vector <uint8_t>::const_iterator &itr) {
+        switch (wire.kind) {
+            case wire_kind::SIGNED:
+            case wire_kind::UNSIGNED:
+                unsignedFromVarintBytes(itr);
+                break;
+            case wire_kind::STRING:
+            case wire_kind::IPFS: {
+                uint64_t length = unsignedFromVarintBytes(itr);
+                itr += length;
+                break;
+            }
+            default:
+                itr += wire.bytes;
+        }
+    }
+
+    void skip_value(const wire_type &wire, std::vector <uint8_t>::const_iterator &itr) {
+        if (wire.array) {
+            uint64_t array_length = unsignedFromVarintBytes(itr);
+            for (uint64_t i = 0; i < array_length; i++) {
+                skip_scalar(wire, itr);
+            }
+        } else {
+            skip_scalar(wire, itr);
+        }
+    }
+
+
+    template <typename T, typename = void>
+    struct has_others : std::false_type {};
+
+    template <typename T>
+    struct has_others <T, std::void_t <decltype(&T::others)>> : std::true_type {};
+
+    template <typename T, typename = void>
+    struct rejects_unbound : std::false_type {};
+
+    template <typename T>
+    struct rejects_unbound <T, std::void_t <decltype(T::reject_unbound)>> : std::bool_constant <T::reject_unbound> {};
+
+    template <typename T, size_t I = 0, typename F>
+    void for_each_bound_field(F &&f) {
+        constexpr auto fields = T::fields();
+        if constexpr (I < std::tuple_size_v <decltype(fields)>) {
+            f(std::get <I>(fields), I);
+            for_each_bound_field <T, I + 1>(f);
+        }
+    }
+
+    template <typename T, size_t I = 0, typename F>
+    void with_bound_field(size_t index, F &&f) {
+        constexpr auto fields = T::fields();
+        if constexpr (I < std::tuple_size_v <decltype(fields)>) {
+            if (index == I) {
+                f(std::get <I>(fields));
+            } else {
+                with_bound_field <T, I + 1>(index, f);
+            }
+        }
+    }
+
+
+    // unbound attribute as it is encoded in the serialized data
+    struct raw_attribute {
+        arena::string name;
+        wire_type wire;
+        std::vector <uint8_t, arena::allocator <uint8_t>> data;
+    };
+
+    typedef std::vector <raw_attribute, arena::allocator <raw_attribute>> RAW_ATTRIBUTES;
+
+
+    static constexpr int8_t UNBOUND = -1;
+
+    template <typename T>
+    struct bound_layout {
+        std::vector <FORMAT> format_lines;
+        std::vector <int8_t> fields; // bound field per format line, UNBOUND if none
+        std::vector <wire_type> wires;
+    };
+
+    template <typename T>
+    bound_layout <T> make_bound_layout(const std::vector <FORMAT> &format_lines) {
+        bound_layout <T> layout;
+        layout.format_lines = format_lines;
+        layout.fields.assign(format_lines.size(), UNBOUND);
+        layout.wires.reserve(format_lines.size());
+
+        for (uint64_t line = 0; line < format_lines.size(); line++) {
+            const wire_type wire = parse_wire_type(format_lines[line].type);
+            layout.wires.push_back(wire);
+
+            for_each_bound_field <T>([&](const auto &field, size_t index) {
+                if (format_lines[line].name != field.name) {
+                    return;
+                }
+                using V = typename std::decay_t <decltype(std::declval <T>().*(field.member))>::value_type;
+                check(accepts <V>(wire), "Attribute " + format_lines[line].name + " has type "
+                    + format_lines[line].type + " in schema, which does not match its binding");
+                layout.fields[line] = (int8_t) index;
+            });
+        }
+        return layout;
+    }
+
+    template <typename T>
+    T decode_bound(const std::vector <uint8_t> &data, const bound_layout <T> &layout) {
+        T result = {};
+
+        auto itr = data.begin();
+        while (itr != data.end()) {
+            uint64_t line = unsignedFromVarintBytes(itr) - RESERVED;
+            check(line < layout.fields.size(), "Attribute identifier is not in schema format");
+
+            if (layout.fields[line] != UNBOUND) {
+                with_bound_field <T>(layout.fields[line], [&](const auto &field) {
+                    using V = typename std::decay_t <decltype(result.*(field.member))>::value_type;
+                    result.*(field.member) = read_value <V>(layout.wires[line], itr);
+                });
+            } else if constexpr (has_others <T>::value) {
+                const std::string &name = layout.format_lines[line].name;
+                const auto begin = itr;
+                skip_value(layout.wires[line], itr);
+                result.others.push_back({arena::string(name.data(), name.size()), layout.wires[line], {begin, itr}});
+            } else if constexpr (rejects_unbound <T>::value) {
+                check(false, "Attribute " + layout.format_lines[line].name + " is not bound and would be lost");
+            } else {
+                skip_value(layout.wires[line], itr);
+            }
+        }
+
+        return result;
+    }
+
+    template <typename T>
+    T decode_bound(const std::vector <uint8_t> &data, const std::vector <FORMAT> &format_lines) {
+        return decode_bound(data, make_bound_layout <T>(format_lines));
+    }
+
+
+    // index of V in ATOMIC_ATTRIBUTE, known at compile time so packing does not visit the variant
+    template <typename V, typename... Ts>
+    constexpr uint32_t alternative_index(const std::variant <Ts...> *) {
+        constexpr bool matches[] = {std::is_same_v <V, Ts>...};
+        for (uint32_t i = 0; i < sizeof...(Ts); i++) {
+            if (matches[i]) {
+                return i;
+            }
+        }
+        return sizeof...(Ts);
+    }
+
+    template <typename V>
+    constexpr uint32_t attribute_index() {
+        constexpr uint32_t index = alternative_index <V>((const ATOMIC_ATTRIBUTE *) nullptr);
+        static_assert(index < std::variant_size_v <ATOMIC_ATTRIBUTE>, "Bound member type is not an atomic attribute type");
+        return index;
+    }
+
+
+    template <typename V8, typename V16, typename V32, typename V64>
+    uint32_t attribute_index_by_width(uint8_t bytes) {
+        return bytes == 1 ? attribute_index <V8>() : bytes == 2 ? attribute_index <V16>()
+            : bytes == 4 ? attribute_index <V32>() : attribute_index <V64>();
+    }
+
+    // index of the ATOMIC_ATTRIBUTE alternative that deserialize_attribute returns for wire
+    uint32_t attribute_index(const wire_type &wire) {
+        switch (wire.kind) {
+            case wire_kind::SIGNED:
+                return wire.array ? attribute_index_by_width <INT8_VEC, INT16_VEC, INT32_VEC, INT64_VEC>(wire.bytes)
+                    : attribute_index_by_width <int8_t, int16_t, int32_t, int64_t>(wire.bytes);
+            case wire_kind::UNSIGNED:
+            case wire_kind::FIXED:
+            case wire_kind::BYTE:
+                return wire.array ? attribute_index_by_width <UINT8_VEC, UINT16_VEC, UINT32_VEC, UINT64_VEC>(wire.bytes)
+                    : attribute_index_by_width <uint8_t, uint16_t, uint32_t, uint64_t>(wire.bytes);
+            case wire_kind::FLOAT:
+                return wire.array ? attribute_index <FLOAT_VEC>() : attribute_index <float>();
+            case wire_kind::DOUBLE:
+                return wire.array ? attribute_index <DOUBLE_VEC>() : attribute_index <double>();
+            default:
+                return wire.array ? attribute_index <string_VEC>() : attribute_index <std::string>();
+        }
+    }
+
+    // unsignedFromVarintBytes over raw_attribute data
+    uint64_t read_varint(const uint8_t *&ptr) {
+        uint64_t number = 0;
+        uint64_t multiplier = 1;
+
+        while (*ptr >= 128) {
+            number += (((uint64_t) *ptr) - 128) * multiplier;
+            ptr++;
+            multiplier *= 128;
+        }
+        number += ((uint64_t) *ptr) * multiplier;
+        ptr++;
+
+        return number;
+    }
+
+    template <typename DataStream>
+    void write_varint(DataStream &ds, uint64_t number) {
+        do {
+            char byte = number & 0x7f;
+            number >>= 7;
+            if (number != 0) {
+                byte |= 0x80;
+            }
+            ds.write(&byte, 1);
+        } while (number != 0);
+    }
+
+    // writes a raw scalar as the ABI packs the ATOMIC_ATTRIBUTE deserialize_attribute would return
+    template <typename DataStream>
+    void pack_raw_scalar(DataStream &ds, const wire_type &wire, const uint8_t *&ptr) {
+        switch (wire.kind) {
+            case wire_kind::SIGNED:
+            case wire_kind::UNSIGNED: {
+                const uint64_t varint = read_varint(ptr);
+                const uint64_t number = wire.kind == wire_kind::SIGNED ? (uint64_t) zigzagDecode(varint) : varint;
+                for (uint8_t i = 0; i < wire.bytes; i++) {
+                    const char byte = number >> (8 * i);
+                    ds.write(&byte, 1);
+                }
+                break;
+            }
+            case wire_kind::STRING: {
+                const uint64_t length = read_varint(ptr);
+                write_varint(ds, length);
+                ds.write((const char *) ptr, length);
+                ptr += length;
+                break;
+            }
+            case wire_kind::IPFS: {
+                const uint64_t length = read_varint(ptr);
+                const std::string text = EncodeBase58(ptr, ptr + length);
+                write_varint(ds, text.size());
+                ds.write(text.data(), text.size());
+                ptr += length;
+                break;
+            }
+            default:
+                // fixed width, float, double and byte are little endian on both sides
+                ds.write((const char *) ptr, wire.bytes);
+                ptr += wire.bytes;
+        }
+    }
+
+    template <typename DataStream>
+    void pack_raw_attribute(DataStream &ds, const raw_attribute &attribute) {
+        write_varint(ds, attribute.name.size());
+        ds.write(attribute.name.data(), attribute.name.size());
+        write_varint(ds, attribute_index(attribute.wire));
+
+        const uint8_t *ptr = attribute.data.data();
+        if (attribute.wire.array) {
+            const uint64_t array_length = read_varint(ptr);
+            write_varint(ds, array_length);
+            for (uint64_t i = 0; i < array_length; i++) {
+                pack_raw_scalar(ds, attribute.wire, ptr);
+            }
+        } else {
+            pack_raw_scalar(ds, attribute.wire, ptr);
+        }
+    }
+
+
+    // Packs a binding in the ABI layout of ATTRIBUTE_MAP, e.g. for setassetdata
+    template <typename T>
+    struct bound_map {
+        const T &value;
+    };
+
+    // Packs as an empty ATTRIBUTE_MAP
+    struct empty_map {};
+
+    template <typename DataStream>
+    DataStream &operator<<(DataStream &ds, const empty_map &) {
+        write_varint(ds, 0);
+        return ds;
+    }
+
+    template <typename DataStream, typename T>
+    DataStream &operator<<(DataStream &ds, const bound_map <T> &map) {
+        uint32_t count = 0;
+        for_each_bound_field <T>([&](const auto &field, size_t) {
+            if ((map.value.*(field.member)).has_value()) {
+                count++;
+            }
+        });
+        if constexpr (has_others <T>::value) {
+            count += map.value.others.size();
+        }
+
+        write_varint(ds, count);
+        for_each_bound_field <T>([&](const auto &field, size_t) {
+            const auto &member = map.value.*(field.member);
+            if (member.has_value()) {
+                using V = typename std::decay_t <decltype(member)>::value_type;
+                // written in place, a std::string of the name would be allocated per item
+                write_varint(ds, strlen(field.name));
+                ds.write(field.name, strlen(field.name));
+                write_varint(ds, attribute_index <V>());
+                ds << *member;
+            }
+        });
+        if constexpr (has_others <T>::value) {
+            for (const raw_attribute &attribute : map.value.others) {
+                pack_raw_attribute(ds, attribute);
+            }
+        }
+        return ds;
+    }
+}
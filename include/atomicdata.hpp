@@ -1,5 +1,31 @@
 #pragma once
+#ifdef ATOMICDATA_NATIVE
+// off-chain tools, check throws instead of aborting the transaction
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace eosio {
+    // literal messages take their own overload like in eosio, a std::string would be built on every call
+    inline void check(bool pred, const char *msg) {
+        if (!pred) {
+            throw std::runtime_error(msg);
+        }
+    }
+
+    inline void check(bool pred, const std::string &msg) {
+        if (!pred) {
+            throw std::runtime_error(msg);
+        }
+    }
+}
+#else
 #include <eosio/eosio.hpp>
+#endif
 #include "base58.hpp"
 
 using namespace eosio;
@@ -56,7 +82,7 @@ namespace atomicdata {
         return bytes;
     }
 
-    uint64_t unsignedFromVarintBytes(std::vector <const uint8_t>::iterator &itr) {
+    uint64_t unsignedFromVarintBytes(std::vector <uint8_t>::const_iterator &itr) {
         uint64_t number = 0;
         uint64_t multiplier = 1;
 
@@ -81,7 +107,7 @@ namespace atomicdata {
         return bytes;
     }
 
-    uint64_t unsignedFromIntBytes(std::vector <const uint8_t>::iterator &itr, uint64_t original_bytes = 8) {
+    uint64_t unsignedFromIntBytes(std::vector <uint8_t>::const_iterator &itr, uint64_t original_bytes = 8) {
         uint64_t number = 0;
         uint64_t multiplier = 1;
 
@@ -324,7 +350,7 @@ namespace atomicdata {
     }
 
 
-    ATOMIC_ATTRIBUTE deserialize_attribute(const std::string &type, std::vector <const uint8_t>::iterator &itr) {
+    ATOMIC_ATTRIBUTE deserialize_attribute(const std::string &type, std::vector <uint8_t>::const_iterator &itr) {
         if (type.find("[]", type.length() - 2) == type.length() - 2) {
             //Type is an array
             uint64_t array_length = unsignedFromVarintBytes(itr);
@@ -2,6 +2,9 @@
 #include <eosio/singleton.hpp>
 #include <eosio/asset.hpp>
 #include "atomicassets.hpp"
+#include "atomicbinding.hpp"
+#include "gamemath.hpp"
+#include "profiler.hpp"
 
 
 using namespace eosio;
@@ -23,11 +26,34 @@ class [[eosio::contract]] game : public contract
     );
 
 
+    struct claim_result
+    {
+      std::map<std::string, float> mined;
+      std::map<std::string, float> balances; // balances of mined resources after claim
+    };
+
+    struct upgrade_result
+    {
+      std::map<std::string, float> claimed; // resources claimed from item before upgrade
+      float                        cost;
+      uint8_t                      level;
+      uint32_t                     upgraded_at; // item mines again from this time
+      std::map<std::string, float> balances; // balance of paid resource after upgrade
+    };
+
+    struct swap_result
+    {
+      asset                   tokens;   // zero when the swap was queued, settle pays it
+      float                   balance;  // resource balance left after swap
+      std::optional<uint64_t> order_id; // set when the swap was queued
+      std::optional<asset>    token_balance; // internal token balance after the swap was paid
+    };
+
     [[eosio::action]]
-    void claim(const name& owner, const uint64_t& farmingitem);
+    claim_result claim(const name& owner, const uint64_t& farmingitem);
 
     [[eosio::action]]
-    void upgradeitem(
+    upgrade_result upgradeitem(
       const name& owner,
       const uint64_t& item_to_upgrade,
       const uint8_t& next_level,
@@ -39,6 +65,37 @@ class [[eosio::contract]] game : public contract
     void upgfarmitem(const name& owner, const uint64_t& farmingitem_to_upgrade, const bool& staked);
 
 
+    struct item_upgrade
+    {
+      uint64_t item;
+      uint8_t  next_level;
+      uint64_t staked_at_farmingitem;
+    };
+
+    struct farmingitem_upgrade
+    {
+      uint64_t farmingitem;
+      uint8_t  slots_to_add;
+      bool     staked;
+    };
+
+    struct upgrademany_result
+    {
+      std::map<std::string, float> claimed;
+      std::map<std::string, float> costs;
+      std::map<std::string, float> balances; // balances written after claimed and costs are netted
+    };
+
+    // upgradeitem and upgfarmitem for many assets with one mdata write per asset
+    // and one balance write per resource
+    [[eosio::action]]
+    upgrademany_result upgrademany(
+      const name& owner,
+      const std::vector<item_upgrade>& items,
+      const std::vector<farmingitem_upgrade>& farmingitems
+    );
+
+
     [[eosio::action]]
     void addblend(
       const std::vector<int32_t>  blend_components,
@@ -50,7 +107,173 @@ class [[eosio::contract]] game : public contract
 
 
     [[eosio::action]]
-    void swap(const name& owner, const std::string& resource, const float& amount2swap);
+    swap_result swap(const name& owner, const std::string& resource, const float& amount2swap);
+
+    // queued: swap takes the resources and records an order, settle pays orders in batches
+    [[eosio::action]]
+    void setswapmode(const bool& queued);
+
+    // anyone may settle up to max_orders oldest orders, each order pays the quote swap recorded
+    // and every owner is credited once
+    [[eosio::action]]
+    void settle(const uint32_t& max_orders);
+
+    // with settle on, swap, upgradeitem and upgrademany claim all pending rewards of owner first
+    // and pay with them in the same balance write
+    [[eosio::action]]
+    void setsettle(const name& owner, const bool& enabled);
+
+    // let the game claim for owner, crank claims every registered owner in turn
+    [[eosio::action]]
+    void setautoclaim(const name& owner, const bool& enabled);
+
+    // claim pending rewards of up to max_owners registered owners, continuing where the last crank stopped
+    [[eosio::action]]
+    void crank(const uint32_t& max_owners);
+
+    // swaps credit tokens to the internal balance of owner, withdraw transfers them out
+    [[eosio::action]]
+    void withdraw(const name& owner, const asset& quantity);
+
+
+    struct dashboard_farm
+    {
+      uint64_t                     farmingitem;
+      uint8_t                      slots;
+      std::vector<uint64_t>        staked_items;
+      std::map<std::string, float> pending_rewards; // same amounts claim would mint right now
+    };
+
+    struct dashboard_balance
+    {
+      std::string resource_name;
+      float       amount;
+      asset       swap_quote; // tokens for swapping the whole balance, zero if resource has no ratio
+    };
+
+    struct dashboard
+    {
+      std::vector<dashboard_farm>    farms;
+      std::vector<dashboard_balance> balances;
+    };
+
+    // read-only: writes no state, result is delivered as action return value
+    [[eosio::action, eosio::read_only]]
+    dashboard getdashboard(const name& owner);
+
+    // convert staked rows of owner to packed_items
+    [[eosio::action]]
+    void packstaked(const name& owner);
+
+    // register owners that staked before the players table existed, complete marks the registry
+    // as holding every owner, which exportstate requires
+    [[eosio::action]]
+    void addplayers(const std::vector<name>& owners, const bool& complete);
+
+    // start walking every player scope with migration, see migrate_scope for known migrations
+    [[eosio::action]]
+    void startmigr(const name& migration);
+
+    // process at most batch_size rows of the running migration and save the cursor
+    [[eosio::action]]
+    void migrate(const uint32_t& batch_size);
+
+    // turn log actions on or off
+    [[eosio::action]]
+    void setlogs(const bool& enabled);
+
+    // fixed width amount of resource, resource_key is the key_id of the resources table
+    struct log_amount
+    {
+      uint64_t resource_key;
+      float    amount;
+    };
+
+    // log actions are sent by the contract to itself so indexers can read events from
+    // the action trace instead of diffing tables, they do nothing
+    [[eosio::action]]
+    void logclaim(const name& owner, const uint64_t& farmingitem, const uint32_t& claimed_at, const std::vector<log_amount>& mined);
+
+    [[eosio::action]]
+    void logswap(const name& owner, const uint64_t& resource_key, const float& amount, const asset& tokens);
+
+    [[eosio::action]]
+    void logstake(const name& owner, const uint64_t& farmingitem, const std::vector<uint64_t>& items);
+
+    [[eosio::action]]
+    void logblend(const name& owner, const uint64_t& blend_id, const uint32_t& count);
+
+    // drop cached template attributes, they are decoded again on next use
+    [[eosio::action]]
+    void refreshtmpl(const name& collection_name, const int32_t& template_id);
+
+    struct leader
+    {
+      name   owner;
+      double mined; // lifetime mined amount of resource
+    };
+
+    // at most limit owners that mined most of resource, highest first
+    [[eosio::action, eosio::read_only]]
+    std::vector<leader> getleaders(const std::string& resource, const uint32_t& limit);
+
+    struct stat
+    {
+      std::string label; // resource name, token symbol or counted thing
+      double      total;
+    };
+
+    struct stats
+    {
+      std::vector<stat> emitted;     // resources mined
+      std::vector<stat> swapped;     // resources given for tokens
+      std::vector<stat> tokens_paid; // tokens credited for swaps
+      std::vector<stat> staked;      // items staked
+    };
+
+    // contract-wide totals since statistics were introduced
+    [[eosio::action, eosio::read_only]]
+    stats getstats();
+
+    // tables in export order, contract scoped tables first, then the owner scoped tables player by player
+    enum export_table : uint8_t
+    {
+      export_blends,
+      export_resourcecost,
+      export_orders,
+      export_autoclaim,
+      export_staked,
+      export_resources,
+      export_ledger,
+      export_mined,
+      export_done
+    };
+
+    struct export_cursor
+    {
+      uint8_t  table;    // export_table
+      uint64_t scope;    // owner of owner scoped tables
+      uint64_t next_key; // first primary key not exported yet
+    };
+
+    struct export_row
+    {
+      uint8_t           table;
+      uint64_t          scope;
+      uint64_t          key;
+      std::vector<char> data; // row packed as stored in the table
+    };
+
+    struct export_page
+    {
+      std::vector<export_row>      rows;
+      std::optional<export_cursor> next; // cursor of the next page, empty after the last page
+    };
+
+    // at most limit rows of state starting at cursor, start with a zero cursor
+    // fails until addplayers ran with complete, owners missing from players would be skipped
+    [[eosio::action, eosio::read_only]]
+    export_page exportstate(const export_cursor& cursor, const uint32_t& limit);
 
 
   private:
@@ -59,11 +282,15 @@ class [[eosio::contract]] game : public contract
   struct [[eosio::table]] staked_j
   {
     uint64_t              asset_id; // item
-    std::vector<uint64_t> staked_items; // farming items
+    std::vector<uint64_t> staked_items; // farming items, only filled at rows not migrated by packstaked
+    binary_extension<std::vector<uint8_t>> packed_items; // sorted staked items: first id, then deltas, as varints
 
     uint64_t primary_key() const { return asset_id; }
+
+    std::vector<uint64_t> get_staked_items() const;
+    void set_staked_items(std::vector<uint64_t> items);
   };
-  typedef multi_index< "staked"_n, staked_j > staked_t;
+  typedef profiler::counted_table<multi_index< "staked"_n, staked_j >> staked_t;
 
   //scope: owner
   struct [[eosio::table]] resources_j
@@ -74,7 +301,7 @@ class [[eosio::contract]] game : public contract
 
     uint64_t primary_key() const { return key_id; }
   };
-  typedef multi_index< "resources"_n, resources_j > resources_t;
+  typedef profiler::counted_table<multi_index< "resources"_n, resources_j >> resources_t;
 
   //scope:contract
   struct [[eosio::table]] blends_j
@@ -85,7 +312,7 @@ class [[eosio::contract]] game : public contract
 
     uint64_t primary_key() const { return blend_id; }
   };
-  typedef multi_index< "blends"_n, blends_j > blends_t;
+  typedef profiler::counted_table<multi_index< "blends"_n, blends_j >> blends_t;
 
   struct [[eosio::table]] resourcecost_j
   {
@@ -95,42 +322,377 @@ class [[eosio::contract]] game : public contract
 
     uint64_t primary_key() const { return key_id; }
   };
-  typedef multi_index< "resourcecost"_n, resourcecost_j > resourcecost_t;
+  typedef profiler::counted_table<multi_index< "resourcecost"_n, resourcecost_j >> resourcecost_t;
+
+  //scope: collection_name
+  // attributes of template immutable data used by the game, decoded once
+  struct [[eosio::table]] tmplcache_j
+  {
+    uint64_t                                template_id;
+    std::optional<float>                    miningRate;
+    std::optional<std::string>              farmResource;
+    std::optional<uint8_t>                  maxLevel;
+    std::optional<uint8_t>                  maxSlots;
+    std::optional<std::vector<std::string>> stakeableResources;
+
+    uint64_t primary_key() const { return template_id; }
+
+    static constexpr auto fields()
+    {
+      return std::make_tuple(
+        atomicdata::bind("miningRate", &tmplcache_j::miningRate),
+        atomicdata::bind("farmResource", &tmplcache_j::farmResource),
+        atomicdata::bind("maxLevel", &tmplcache_j::maxLevel),
+        atomicdata::bind("maxSlots", &tmplcache_j::maxSlots),
+        atomicdata::bind("stakeableResources", &tmplcache_j::stakeableResources)
+      );
+    }
+  };
+  typedef profiler::counted_table<multi_index< "tmplcache"_n, tmplcache_j >> tmplcache_t;
+
+  // mutable data of farming items and items, attributes the game does not use are kept undecoded in others
+  // GAME_MINIMAL builds drop others, mutable data may then hold only these attributes
+  struct asset_mdata
+  {
+    std::optional<uint8_t>      level;
+    std::optional<uint8_t>      slots;       // farming items
+    std::optional<uint32_t>     lastClaim;   // items
+    std::optional<float>        miningBoost; // farming items
+#ifndef GAME_MINIMAL
+    atomicdata::RAW_ATTRIBUTES  others;      // memory of the open arena::scope
+#else
+    static constexpr bool reject_unbound = true;
+#endif
+
+    static constexpr auto fields()
+    {
+      return std::make_tuple(
+        atomicdata::bind("level", &asset_mdata::level),
+        atomicdata::bind("slots", &asset_mdata::slots),
+        atomicdata::bind("lastClaim", &asset_mdata::lastClaim),
+        atomicdata::bind("miningBoost", &asset_mdata::miningBoost)
+      );
+    }
+  };
+
+  // mdata layouts of schemas resolved in this action, key: collection and schema name
+  std::map<std::pair<uint64_t, uint64_t>, atomicdata::bound_layout<asset_mdata>> mdata_layouts;
+  // template attributes read in this action, key: collection and template id, value: attributes and whether they are in tmplcache
+  std::map<std::pair<uint64_t, int32_t>, std::pair<tmplcache_j, bool>> template_attrs_memo;
+
+  //scope: contract
+  // every owner that has staked, lets maintenance actions walk owner scopes
+  struct [[eosio::table]] players_j
+  {
+    name owner;
+
+    uint64_t primary_key() const { return owner.value; }
+  };
+  typedef profiler::counted_table<multi_index< "players"_n, players_j >> players_t;
+
+  //scope: contract
+  struct [[eosio::table]] migration_j
+  {
+    name     migration;        // running migration, empty when idle
+    uint64_t scope;            // owner being processed
+    uint64_t next_key;         // first row of scope not processed yet
+    uint64_t scopes_done;
+    uint64_t rows_migrated;
+    uint64_t rows_skipped;     // rows that already had the new layout
+  };
+  typedef profiler::counted_singleton<singleton< "migration"_n, migration_j >> migration_t;
+
+  //scope: owner
+  // lifetime mined amounts, unlike resources they do not fall on upgrades and swaps
+  struct [[eosio::table]] mined_j
+  {
+    uint64_t key_id; // same key as resources
+    double   total;
+
+    uint64_t primary_key() const { return key_id; }
+  };
+  typedef profiler::counted_table<multi_index< "mined"_n, mined_j >> mined_t;
+
+  // owners kept per resource in leaders
+  static constexpr uint32_t leaderboard_size = 100;
+
+  //scope: contract
+  // top leaderboard_size owners by lifetime mined total of each resource
+  struct [[eosio::table]] leaders_j
+  {
+    uint64_t id;
+    uint64_t resource_key;
+    name     owner;
+    double   total;
+
+    uint64_t primary_key() const { return id; }
+    // non-negative doubles sort like their bits
+    uint128_t by_total() const
+    {
+      uint64_t total_bits;
+      memcpy(&total_bits, &total, sizeof(total_bits));
+      return (uint128_t(resource_key) << 64) | total_bits;
+    }
+    uint128_t by_owner() const { return (uint128_t(resource_key) << 64) | owner.value; }
+  };
+  typedef profiler::counted_table<multi_index< "leaders"_n, leaders_j,
+    indexed_by<"bytotal"_n, const_mem_fun<leaders_j, uint128_t, &leaders_j::by_total>>,
+    indexed_by<"byowner"_n, const_mem_fun<leaders_j, uint128_t, &leaders_j::by_owner>>
+  >> leaders_t;
+
+  //scope: contract
+  // number of leaders rows of resource
+  struct [[eosio::table]] boards_j
+  {
+    uint64_t resource_key;
+    uint32_t size;
+
+    uint64_t primary_key() const { return resource_key; }
+  };
+  typedef profiler::counted_table<multi_index< "boards"_n, boards_j >> boards_t;
+
+  //scope: owner
+  // tokens earned by swaps and not withdrawn yet
+  struct [[eosio::table]] ledger_j
+  {
+    asset balance;
+
+    uint64_t primary_key() const { return balance.symbol.code().raw(); }
+  };
+  typedef profiler::counted_table<multi_index< "ledger"_n, ledger_j >> ledger_t;
+
+  //scope: contract
+  // queued swaps, the resources are already taken from the owner's balance
+  struct [[eosio::table]] orders_j
+  {
+    uint64_t id;
+    name     owner;
+    uint64_t resource_key;
+    float    amount;
+    asset    tokens; // quoted when the swap was queued, a later ratio change does not touch it
+
+    uint64_t primary_key() const { return id; }
+  };
+  typedef profiler::counted_table<multi_index< "orders"_n, orders_j >> orders_t;
+
+  //scope: metric, one of emitted, swapped, tokens, staked
+  // contract-wide totals, key: resource key, token symbol code or 0
+  struct [[eosio::table]] stats_j
+  {
+    uint64_t    key;
+    std::string label;
+    double      total;
+
+    uint64_t primary_key() const { return key; }
+  };
+  typedef profiler::counted_table<multi_index< "stats"_n, stats_j >> stats_t;
+
+  //scope: contract
+  // owners that let crank claim for them
+  struct [[eosio::table]] autoclaim_j
+  {
+    name owner;
+
+    uint64_t primary_key() const { return owner.value; }
+  };
+  typedef profiler::counted_table<multi_index< "autoclaim"_n, autoclaim_j >> autoclaim_t;
+
+  //scope: contract
+  struct [[eosio::table]] crank_j
+  {
+    uint64_t next_owner = 0; // first owner of the next crank
+  };
+  typedef profiler::counted_singleton<singleton< "crank"_n, crank_j >> crank_t;
+
+  //scope: owner
+  struct [[eosio::table]] settings_j
+  {
+    bool settle_rewards = false;
+  };
+  typedef profiler::counted_singleton<singleton< "settings"_n, settings_j >> settings_t;
+
+  //scope: contract
+  struct [[eosio::table]] config_j
+  {
+    bool emit_logs = true;
+    binary_extension<bool> queue_swaps; // false if missing
+    binary_extension<bool> players_complete; // players holds every owner, false if missing
+  };
+  typedef profiler::counted_singleton<singleton< "config"_n, config_j >> config_t;
+
+  // config read by this action, an action that logs many events reads the singleton once
+  std::optional<config_j> game_config;
+  const config_j& get_game_config();
 
 
 
+  // atomicassets tables as read by the game, counted like the game's own tables
+  typedef profiler::counted_table<atomicassets::assets_t>    assets_t;
+  typedef profiler::counted_table<atomicassets::templates_t> templates_t;
+  typedef profiler::counted_table<atomicassets::schemas_t>   schemas_t;
+
+  assets_t get_assets(const name& owner) { return assets_t(atomicassets::ATOMICASSETS_ACCOUNT, owner.value); }
+  templates_t get_templates(const name& collection_name) { return templates_t(atomicassets::ATOMICASSETS_ACCOUNT, collection_name.value); }
+  schemas_t get_schemas(const name& collection_name) { return schemas_t(atomicassets::ATOMICASSETS_ACCOUNT, collection_name.value); }
+
   const uint64_t stringToUint64(const std::string& str);
 
   void stake_farmingitem(const name& owner, const uint64_t& asset_id);
   void stake_items(const name& owner, const uint64_t& farmingitem, const std::vector<uint64_t>& items_to_stake);
+  // farmingitems: farming item -> items to stake at it
+  void stake_batch(const name& owner, const std::vector<uint64_t>& asset_ids, const std::map<uint64_t, std::vector<uint64_t>>& farmingitems);
+  std::map<uint64_t, std::vector<uint64_t>> parse_stake_batch(const std::string& batch);
+
+  void register_player(const name& owner);
+
+  template<typename... Args>
+  void send_log(const name& log_action, const Args&... args)
+  {
+    if(!get_game_config().emit_logs)
+      return;
+
+    send_action(get_self(), log_action, args...);
+  }
+
+  // WASM heap is never freed during an action, so inline actions are packed into inline_buffer,
+  // which is reused for the whole action, instead of a new action and pack buffer per item
+  std::vector<char> inline_buffer;
+
+  // sends an inline action with active permission of self, packed like eosio::action
+  template<typename... Args>
+  void send_action(const name& account, const name& action_name, const Args&... args)
+  {
+    const permission_level authorization{get_self(), "active"_n};
+    const size_t data_size = (pack_size(args) + ... + 0);
+    const size_t size = pack_size(account) + pack_size(action_name)
+                      + pack_size(unsigned_int(1)) + pack_size(authorization)
+                      + pack_size(unsigned_int(data_size)) + data_size;
+
+    inline_buffer.resize(size);
+    datastream<char*> ds(inline_buffer.data(), size);
+    ds << account << action_name << unsigned_int(1) << authorization << unsigned_int(data_size);
+    (ds << ... << args);
+
+    internal_use_do_not_use::send_inline(inline_buffer.data(), size);
+    GAME_PROFILE_COUNT(inline_actions);
+  }
+
+  // rows per exportstate page, keeps the return value well below action limits
+  static constexpr uint32_t max_export_rows = 500;
+
+  // returns true when table has no rows left after cursor, false when budget ran out
+  template<typename Table>
+  bool export_rows(Table& table, export_cursor& cursor, std::vector<export_row>& rows, uint32_t& budget)
+  {
+    for(auto table_itr = table.lower_bound(cursor.next_key); table_itr != std::end(table); ++table_itr)
+    {
+      if(budget == 0)
+      {
+        cursor.next_key = table_itr->primary_key();
+        return false;
+      }
+      --budget;
+
+      rows.push_back({cursor.table, cursor.scope, table_itr->primary_key(), pack(*table_itr)});
+    }
+    return true;
+  }
+
+  // returns true when every row of owner was processed, false when budget ran out
+  bool migrate_scope(migration_j& cursor, const name& owner, uint32_t& budget);
+  // returns false if row already was packed
+  bool pack_staked_row(staked_t& staked_table, staked_t::const_iterator& staked_table_itr);
+
+  void init_farmingitem(
+    atomicassets::assets_t::const_iterator& asset_itr,
+    asset_mdata& farmingitem_mdata,
+    const tmplcache_j& farmingitem_template_attrs
+  );
+  void init_item(
+    atomicassets::assets_t::const_iterator& asset_itr,
+    const tmplcache_j& template_attrs,
+    const std::vector<std::string>& stakeableResources
+  );
 
-  void increase_owner_resources_balance(const name& owner, const std::map<std::string, float>& resources);
-  void reduce_owner_resources_balance(const name& owner, const std::map<std::string, float>& resources);
+  // both return the new balances of the changed resources
+  std::map<std::string, float> increase_owner_resources_balance(const name& owner, const std::map<std::string, float>& resources);
+  // applies credit and debit, netted per resource, returns balances of every resource in them
+  std::map<std::string, float> net_owner_resources_balance(
+    const name& owner,
+    const std::map<std::string, float>& credit,
+    const std::map<std::string, float>& debit
+  );
+  // add mined resources to lifetime totals and leaderboards, balances are changed by increase_owner_resources_balance
+  void add_mined(const name& owner, const std::map<std::string, float>& mined);
+  void update_leaderboard(const name& owner, const uint64_t& resource_key, const double& total);
+  void add_stat(const name& metric, const uint64_t& key, const std::string& label, const double& amount);
+  std::vector<stat> get_stats(const name& metric);
+  std::map<std::string, float> reduce_owner_resources_balance(const name& owner, const std::map<std::string, float>& resources);
+
+  // resource mined by an item, resource points into the template attributes memoized for this action,
+  // so no resource name is copied per item
+  struct resource_reward
+  {
+    const std::string* resource = nullptr;
+    float              amount   = 0;
+  };
 
-  const std::pair<std::string, float> claim_item(atomicassets::assets_t::const_iterator& assets_itr, const uint8_t& upgrade_percentage, const uint32_t& time_now);
+  resource_reward claim_item(atomicassets::assets_t::const_iterator& assets_itr, const uint8_t& upgrade_percentage, const uint32_t& time_now);
+  // claim every staked item of owner except skip_items without touching balances, returns claimed resources
+  std::map<std::string, float> claim_pending(
+    const name& owner,
+    const uint32_t& time_now,
+    const std::set<uint64_t>& skip_items,
+    const assets_t& assets
+  );
+  void log_claim(const name& owner, const uint64_t& farmingitem, const uint32_t& time_now, const std::map<std::string, float>& mined_resources);
+  bool settles_rewards(const name& owner);
+  // reward mined by item since lastClaim, without updating the item
+  resource_reward get_item_reward(
+    const asset_mdata& item_mdata,
+    const tmplcache_j& template_attrs,
+    const uint8_t& upgrade_percentage,
+    const uint32_t& time_now
+  );
 
-  void upgrade_item(
+  upgrade_result upgrade_item(
     atomicassets::assets_t::const_iterator& assets_itr,
     const uint8_t& upgrade_percentage,
     const name& owner,
     const uint8_t& new_level,
+    const uint32_t& time_now,
+    const std::map<std::string, float>& claimed // pays for the upgrade first
+  );
+
+  // sets new level and upgrade end to mdata, returns resource and amount to pay
+  const std::pair<std::string, float> apply_item_upgrade(
+    asset_mdata& mdata,
+    const tmplcache_j& template_attrs,
+    const uint8_t& upgrade_percentage,
+    const uint8_t& new_level,
     const uint32_t& time_now
   );
 
-  void upgrade_farmingitem(atomicassets::assets_t::const_iterator& assets_itr, const name& owner);
+  void upgrade_farmingitem(atomicassets::assets_t::const_iterator& assets_itr, const name& owner, const uint8_t& slots_to_add);
 
-  void blend(const name& owner, const std::vector<uint64_t> asset_ids, const uint64_t& blend_id);
+  void blend(const name& owner, const std::vector<uint64_t> asset_ids, const uint64_t& blend_id, const uint32_t& count);
 
 
 
   void tokens_transfer(const name& to, const asset& quantity);
-
-  const int32_t get_upgrading_time(const uint8_t& end_level);
+  // returns internal token balance of owner after quantity was added
+  asset credit_tokens(const name& owner, const asset& quantity);
+  const asset get_swap_quote(const float& amount2swap, const float& ratio);
 
   // get mutable data from NFT
-  atomicassets::ATTRIBUTE_MAP get_mdata(atomicassets::assets_t::const_iterator& assets_itr);
+  asset_mdata get_mdata(atomicassets::assets_t::const_iterator& assets_itr);
+  const atomicdata::bound_layout<asset_mdata>& get_mdata_layout(const name& collection_name, const name& schema_name);
   // get immutable data from template of NFT
-  atomicassets::ATTRIBUTE_MAP get_template_idata(const int32_t& template_id, const name& collection_name);
+  tmplcache_j get_template_idata(const int32_t& template_id, const name& collection_name);
+  // get game attributes of template from tmplcache, decoding them on miss, writes nothing so read-only actions can use it
+  const tmplcache_j& find_template_attrs(const int32_t& template_id, const name& collection_name);
+  // same as find_template_attrs, stores decoded attributes in tmplcache on miss
+  const tmplcache_j& get_template_attrs(const int32_t& template_id, const name& collection_name);
   // update mutable data of NFT
-  void update_mdata(atomicassets::assets_t::const_iterator& assets_itr, const atomicassets::ATTRIBUTE_MAP& new_mdata, const name& owner);
+  void update_mdata(atomicassets::assets_t::const_iterator& assets_itr, const asset_mdata& new_mdata, const name& owner);
 };
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+
+// Reward, upgrade and swap math of the game.
+// Free of eosio so that native tools (tools/simulator.cpp) compute exactly what the contract does.
+namespace gamemath
+{
+  // percentage of increase in mine rate for each level
+  constexpr uint8_t upgrade_percentage = 2;
+
+  // token precision of swaps, GAME has 4 decimals
+  constexpr int64_t token_precision = 10000;
+
+  inline float mining_rate(const float& miningRate, const uint8_t& level, const uint8_t& upgrade_percentage)
+  {
+    //calculate mining rate according to lvl
+    float miningRate_according2lvl = miningRate;
+    for(uint8_t i = 1; i < level; ++i)
+      miningRate_according2lvl = miningRate_according2lvl + (miningRate_according2lvl * upgrade_percentage / 100);
+
+    return miningRate_according2lvl;
+  }
+
+  // total upgrading time from level 1 to end_level
+  inline int32_t upgrading_time(const uint8_t& end_level)
+  {
+    const int32_t increasing_time = 320; // 5.33 min
+    int32_t total_time = 0;
+    int32_t temp_tracker = 0;
+    for(uint8_t i = 2; i <= end_level; ++i)
+    {
+      if(i % 5 == 0)
+      {
+        total_time += (temp_tracker * 5);
+      }
+      else
+      {
+        temp_tracker += increasing_time;
+        total_time += increasing_time;
+      }
+    }
+    return total_time;
+  }
+
+  inline int32_t upgrade_time(const uint8_t& current_lvl, const uint8_t& new_level)
+  {
+    return upgrading_time(new_level) - upgrading_time(current_lvl);
+  }
+
+  // the resource price of an upgrade is what the item mines at the new level during the upgrade
+  inline float upgrade_cost(const float& miningRate, const uint8_t& current_lvl, const uint8_t& new_level, const uint8_t& upgrade_percentage)
+  {
+    return upgrade_time(current_lvl, new_level) * mining_rate(miningRate, new_level, upgrade_percentage);
+  }
+
+  // resources mined since lastClaim, nothing while the item is upgrading
+  inline float reward(const float& miningRate, const uint8_t& level, const uint8_t& upgrade_percentage, const uint32_t& lastClaim, const uint32_t& time_now)
+  {
+    if(time_now <= lastClaim)
+      return 0;
+
+    return (time_now - lastClaim) * mining_rate(miningRate, level, upgrade_percentage);
+  }
+
+  // token amount in units of 1 / token_precision for amount2swap resources
+  inline int64_t swap_amount(const float& amount2swap, const float& ratio)
+  {
+    const float token_amount = amount2swap / ratio;
+    return token_amount * token_precision;
+  }
+
+  // why amount2swap resources can not be swapped at ratio, nullptr if they can
+  inline const char* swap_error(const float& amount2swap, const float& ratio)
+  {
+    // negated so that NaN fails too
+    if(!(amount2swap > 0))
+      return "Swap amount must be positive";
+    if(!(ratio > 0))
+      return "Swap ratio must be positive";
+    // asset amounts stay below 2^62
+    if(!(amount2swap / ratio * token_precision < 4611686018427387904.0f))
+      return "Swap amount is too large";
+    if(swap_amount(amount2swap, ratio) <= 0)
+      return "Swap amount is too small to receive tokens";
+    return nullptr;
+  }
+}
@@ -0,0 +1,172 @@
+#pragma once
+#include <eosio/eosio.hpp>
+#include "arena.hpp"
+
+// Hot path counters for performance budgets, built only with -DGAME_PROFILE.
+// Counters are printed to the action console when a profiled action returns,
+// without GAME_PROFILE every macro expands to nothing and the table wrappers are the plain tables.
+// WASM has no clock finer than block time, so calls are counted, not timed, and the arena size is printed.
+//
+// Table reads and writes are counted by counted_table and counted_singleton, every table type of
+// the game is declared through them, so call sites need no counting of their own.
+//
+// GAME_PROFILE_BUDGET fails a profiled action whose counter went over budget. Running a profiled
+// build on a local node therefore tests the budgets of every action that declares them.
+#ifdef GAME_PROFILE
+
+namespace profiler
+{
+    enum counter : uint8_t
+    {
+        mdata_reads,    // get_mdata
+        idata_reads,    // get_template_idata
+        mdata_writes,   // update_mdata
+        decodes,        // atomicdata decodes of mutable and immutable data
+        db_reads,       // rows loaded by lookups and iteration
+        db_writes,      // emplace / modify / erase / singleton set
+        inline_actions, // send_action
+        COUNTERS
+    };
+
+    static const char* counter_names[COUNTERS] =
+    {
+        "mdata_reads", "idata_reads", "mdata_writes", "decodes", "db_reads", "db_writes", "inline_actions"
+    };
+
+    // every action runs in a fresh WASM instance, so counters start at zero
+    static uint32_t counters[COUNTERS] = {};
+
+    struct scope
+    {
+        const char* action_name;
+
+        explicit scope(const char* action_name) : action_name(action_name) {}
+
+        ~scope()
+        {
+            eosio::print("profile ", action_name, ":");
+            for(uint8_t i = 0; i < COUNTERS; ++i)
+                eosio::print(" ", counter_names[i], "=", counters[i]);
+            // blocks of the per-item arena, flat in the item count when per-item temporaries stay in it
+            eosio::print(" arena_bytes=", arena::get_state().reserved);
+            eosio::print("\n");
+        }
+    };
+
+    inline void check_budget(const counter& c, const uint32_t& budget)
+    {
+        if(counters[c] > budget)
+            eosio::check(false, std::string("profile budget exceeded: ") + counter_names[c] + " = "
+                + std::to_string(counters[c]) + " > " + std::to_string(budget));
+    }
+
+    // multi_index or secondary index of it, every row loaded by a lookup or an iterator step is a read
+    template <typename Table>
+    class counted_table : public Table
+    {
+      public:
+        using Table::Table;
+        using base_iterator = typename Table::const_iterator;
+
+        counted_table(const Table& table) : Table(table) {}
+
+        struct const_iterator : base_iterator
+        {
+            const_iterator() {}
+            const_iterator(const base_iterator& itr) : base_iterator(itr) {}
+
+            const_iterator& operator++() { ++counters[db_reads]; base_iterator::operator++(); return *this; }
+            const_iterator& operator--() { ++counters[db_reads]; base_iterator::operator--(); return *this; }
+            const_iterator operator++(int) { const_iterator itr = *this; ++*this; return itr; }
+            const_iterator operator--(int) { const_iterator itr = *this; --*this; return itr; }
+        };
+
+        const_iterator begin() const { ++counters[db_reads]; return Table::begin(); }
+        const_iterator end() const { return Table::end(); }
+
+        template <typename Key>
+        const_iterator find(const Key& key) const { ++counters[db_reads]; return Table::find(key); }
+
+        template <typename Key, typename Message>
+        const_iterator require_find(const Key& key, const Message& error_msg) const
+        {
+            ++counters[db_reads];
+            return Table::require_find(key, error_msg);
+        }
+
+        template <typename Key>
+        const_iterator lower_bound(const Key& key) const { ++counters[db_reads]; return Table::lower_bound(key); }
+
+        template <typename Key>
+        const_iterator upper_bound(const Key& key) const { ++counters[db_reads]; return Table::upper_bound(key); }
+
+        template <typename Lambda>
+        const_iterator emplace(const eosio::name& payer, Lambda&& constructor)
+        {
+            ++counters[db_writes];
+            return Table::emplace(payer, std::forward<Lambda>(constructor));
+        }
+
+        template <typename Lambda>
+        void modify(const base_iterator& itr, const eosio::name& payer, Lambda&& updater)
+        {
+            ++counters[db_writes];
+            Table::modify(itr, payer, std::forward<Lambda>(updater));
+        }
+
+        const_iterator erase(const base_iterator& itr)
+        {
+            ++counters[db_writes];
+            return Table::erase(itr);
+        }
+
+        template <eosio::name::raw IndexName>
+        auto get_index()
+        {
+            using index_t = decltype(Table::template get_index<IndexName>());
+            return counted_table<index_t>(Table::template get_index<IndexName>());
+        }
+    };
+
+    template <typename Singleton>
+    class counted_singleton : public Singleton
+    {
+      public:
+        using Singleton::Singleton;
+
+        template <typename... Default>
+        auto get_or_default(const Default&... def)
+        {
+            ++counters[db_reads];
+            return Singleton::get_or_default(def...);
+        }
+
+        template <typename T>
+        void set(const T& value, const eosio::name& payer)
+        {
+            ++counters[db_writes];
+            Singleton::set(value, payer);
+        }
+    };
+}
+
+#define GAME_PROFILE_SCOPE(action_name) profiler::scope game_profile_scope(action_name)
+#define GAME_PROFILE_COUNT(counter) ++profiler::counters[profiler::counter]
+#define GAME_PROFILE_BUDGET(counter, budget) profiler::check_budget(profiler::counter, budget)
+
+#else
+
+namespace profiler
+{
+    template <typename Table>
+    using counted_table = Table;
+
+    template <typename Singleton>
+    using counted_singleton = Singleton;
+}
+
+#define GAME_PROFILE_SCOPE(action_name)
+#define GAME_PROFILE_COUNT(counter)
+#define GAME_PROFILE_BUDGET(counter, budget)
+
+#endif
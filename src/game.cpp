@@ -11,6 +11,8 @@ void game::receive_asset_transfer
   if(to != get_self())
     return;
 
+  GAME_PROFILE_SCOPE("receive_asset_transfer");
+
   if(memo == "stake farming item")
   {
     check(asset_ids.size() == 1, "You must transfer only one farming item to stake");
@@ -21,10 +23,19 @@ void game::receive_asset_transfer
     const uint64_t farmingitem_id = std::stoll(memo.substr(12));
     stake_items(from, farmingitem_id, asset_ids);
   }
+  else if(memo.find("stake batch:") != std::string::npos)
+  {
+    // stake batch:<farmingitem>=<item>,<item>;<farmingitem>=<item>
+    // transferred farming items are staked first, the others must be staked already
+    stake_batch(from, asset_ids, parse_stake_batch(memo.substr(12)));
+  }
   else if(memo.find("blend:") != std::string::npos)
   {
+    // blend:<id> or blend:<id>:x<count> to run the blend count times
     const uint64_t blend_id = std::stoll(memo.substr(6));
-    blend(from, asset_ids, blend_id);
+    const size_t count_pos  = memo.find(":x", 6);
+    const uint32_t count    = count_pos == std::string::npos ? 1 : std::stoul(memo.substr(count_pos + 2));
+    blend(from, asset_ids, blend_id, count);
   }
   else
     check(0, "Invalid memo");
@@ -34,111 +45,267 @@ void game::receive_asset_transfer
 
 void game::stake_farmingitem(const name& owner, const uint64_t& asset_id)
 {
-    auto assets       = atomicassets::get_assets(get_self());
+    auto assets       = get_assets(get_self());
     auto asset_itr    = assets.find(asset_id);
+    if(asset_itr == std::end(assets))
+        check(false, "Could not find farming item[" + std::to_string(asset_id) + "]");
 
     auto farmingitem_mdata = get_mdata(asset_itr);
-    if(farmingitem_mdata.find("slots") == std::end(farmingitem_mdata))
-    {
-        auto farmingitem_template_idata = get_template_idata(asset_itr->template_id, asset_itr->collection_name);
-        check(farmingitem_template_idata.find("maxSlots") != std::end(farmingitem_template_idata),
-            "Farming item slots was not initialized. Contact ot dev team");
-        check(farmingitem_template_idata.find("stakeableResources") != std::end(farmingitem_template_idata),
-            "stakeableResources items at current farming item was not initialized. Contact to dev team");
-
-        farmingitem_mdata["slots"] = (uint8_t)1;
-        farmingitem_mdata["level"] = (uint8_t)1;
-
-        update_mdata(asset_itr, farmingitem_mdata, get_self());
-    }
+    init_farmingitem(asset_itr, farmingitem_mdata, get_template_attrs(asset_itr->template_id, asset_itr->collection_name));
     
     staked_t staked_table(get_self(), owner.value);
     staked_table.emplace(get_self(), [&](auto &new_row)
     {
         new_row.asset_id = asset_id;
+        new_row.set_staked_items({});
     });
+
+    register_player(owner);
+    send_log("logstake"_n, owner, asset_id, std::vector<uint64_t>());
 }
 
 
 void game::stake_items(const name& owner, const uint64_t& farmingitem, const std::vector<uint64_t>& items_to_stake)
 {
-    auto assets       = atomicassets::get_assets(get_self());
+    auto assets       = get_assets(get_self());
 
     staked_t staked_table(get_self(), owner.value);
     auto staked_table_itr = staked_table.require_find(farmingitem, "Could not find farming staked item");
     auto asset_itr = assets.find(farmingitem);
+    if(asset_itr == std::end(assets))
+        check(false, "Could not find farming item[" + std::to_string(farmingitem) + "]");
 
     auto farmingitem_mdata          = get_mdata(asset_itr);
-    auto farmingitem_template_idata = get_template_idata(asset_itr->template_id, asset_itr->collection_name); 
+    const auto& farmingitem_template_attrs = get_template_attrs(asset_itr->template_id, asset_itr->collection_name);
 
-    check(std::get<uint8_t>(farmingitem_mdata["slots"]) >= staked_table_itr->staked_items.size() + items_to_stake.size(),
+    std::vector<uint64_t> staked_items = staked_table_itr->get_staked_items();
+    check(farmingitem_mdata.slots.value() >= staked_items.size() + items_to_stake.size(),
      "You don't have empty slots on current farming item to stake this amount of items");
 
-    atomicdata::string_VEC stakeableResources = std::get<atomicdata::string_VEC>(farmingitem_template_idata["stakeableResources"]);
-    for(const uint64_t& item_to_stake : items_to_stake)
+    const atomicdata::string_VEC& stakeableResources = farmingitem_template_attrs.stakeableResources.value();
+    for(auto item_itr : atomicassets::find_assets(assets, items_to_stake))
+        init_item(item_itr, get_template_attrs(item_itr->template_id, item_itr->collection_name), stakeableResources);
+
+    staked_table.modify(staked_table_itr, get_self(), [&](auto &new_row)
+    {
+        staked_items.insert(std::end(staked_items), std::begin(items_to_stake), std::end(items_to_stake));
+        new_row.set_staked_items(staked_items);
+    });
+
+    add_stat("staked"_n, 0, "items", items_to_stake.size());
+    send_log("logstake"_n, owner, farmingitem, items_to_stake);
+
+    // worst case per item: its own schema and template, none of them read before in this action
+    GAME_PROFILE_BUDGET(db_reads,       8 + items_to_stake.size() * 6);
+    GAME_PROFILE_BUDGET(db_writes,      3 + items_to_stake.size());
+    GAME_PROFILE_BUDGET(decodes,        2 + items_to_stake.size() * 2);
+    GAME_PROFILE_BUDGET(inline_actions, 1 + items_to_stake.size());
+}
+
+
+void game::stake_batch(const name& owner, const std::vector<uint64_t>& asset_ids, const std::map<uint64_t, std::vector<uint64_t>>& farmingitems)
+{
+    // every transferred asset has to be listed exactly once, either as farming item or as item
+    std::set<uint64_t> transferred(std::begin(asset_ids), std::end(asset_ids));
+    std::set<uint64_t> new_farmingitems;
+    for(const auto& farmingitem : farmingitems)
+    {
+        if(transferred.erase(farmingitem.first) > 0)
+            new_farmingitems.insert(farmingitem.first);
+
+        for(const uint64_t& item : farmingitem.second)
+            check(transferred.erase(item) > 0, "Item [" + std::to_string(item) + "] was not transferred or is listed twice");
+    }
+    check(transferred.empty(), "Asset [" + std::to_string(transferred.empty() ? 0 : *std::begin(transferred)) + "] is not listed in memo");
+
+    auto assets = get_assets(get_self());
+    staked_t staked_table(get_self(), owner.value);
+    if(!new_farmingitems.empty())
+        register_player(owner);
+
+    for(const auto& farmingitem : farmingitems)
+    {
+        auto asset_itr = assets.find(farmingitem.first);
+        if(asset_itr == std::end(assets))
+            check(false, "Could not find farming item[" + std::to_string(farmingitem.first) + "]");
+        auto farmingitem_mdata = get_mdata(asset_itr);
+        const tmplcache_j& farmingitem_template_attrs = get_template_attrs(asset_itr->template_id, asset_itr->collection_name);
+
+        const bool is_new = new_farmingitems.count(farmingitem.first) > 0;
+        std::vector<uint64_t> staked_items;
+        auto staked_table_itr = std::end(staked_table);
+        if(is_new)
+            init_farmingitem(asset_itr, farmingitem_mdata, farmingitem_template_attrs);
+        else
+        {
+            staked_table_itr = staked_table.require_find(farmingitem.first, "Could not find farming staked item");
+            staked_items = staked_table_itr->get_staked_items();
+        }
+
+        if(!farmingitem.second.empty())
+        {
+            check(farmingitem_mdata.slots.value() >= staked_items.size() + farmingitem.second.size(),
+                "You don't have empty slots on farming item[" + std::to_string(farmingitem.first) + "] to stake this amount of items");
+
+            const atomicdata::string_VEC& stakeableResources = farmingitem_template_attrs.stakeableResources.value();
+            for(auto item_itr : atomicassets::find_assets(assets, farmingitem.second))
+                init_item(item_itr, get_template_attrs(item_itr->template_id, item_itr->collection_name), stakeableResources);
+            staked_items.insert(std::end(staked_items), std::begin(farmingitem.second), std::end(farmingitem.second));
+        }
+
+        if(is_new)
+        {
+            staked_table.emplace(get_self(), [&](auto &new_row)
+            {
+                new_row.asset_id = farmingitem.first;
+                new_row.set_staked_items(staked_items);
+            });
+        }
+        else if(!farmingitem.second.empty())
+        {
+            staked_table.modify(staked_table_itr, get_self(), [&](auto &new_row)
+            {
+                new_row.set_staked_items(staked_items);
+            });
+        }
+
+        if(is_new || !farmingitem.second.empty())
+            send_log("logstake"_n, owner, farmingitem.first, farmingitem.second);
+    }
+
+    const uint64_t items_staked = asset_ids.size() - new_farmingitems.size();
+    if(items_staked > 0)
+        add_stat("staked"_n, 0, "items", items_staked);
+}
+
+
+std::map<uint64_t, std::vector<uint64_t>> game::parse_stake_batch(const std::string& batch)
+{
+    std::map<uint64_t, std::vector<uint64_t>> farmingitems;
+
+    size_t farmingitem_begin = 0;
+    while(farmingitem_begin < batch.size())
     {
-        asset_itr = assets.find(item_to_stake);
-        auto item_mdata = get_mdata(asset_itr);
+        size_t farmingitem_end = batch.find(';', farmingitem_begin);
+        if(farmingitem_end == std::string::npos)
+            farmingitem_end = batch.size();
+
+        const std::string entry = batch.substr(farmingitem_begin, farmingitem_end - farmingitem_begin);
+        const size_t separator = entry.find('=');
+        check(separator != std::string::npos, "Invalid memo");
 
-        item_mdata["lastClaim"] = current_time_point().sec_since_epoch();
-        auto template_idata = get_template_idata(asset_itr->template_id, asset_itr->collection_name);
-        if(item_mdata.find("level") == std::end(item_mdata))
+        const uint64_t farmingitem = std::stoull(entry.substr(0, separator));
+        check(farmingitems.find(farmingitem) == std::end(farmingitems),
+            "Farming item [" + std::to_string(farmingitem) + "] is listed twice");
+        std::vector<uint64_t>& items = farmingitems[farmingitem];
+
+        size_t item_begin = separator + 1;
+        while(item_begin < entry.size())
         {
-            check(template_idata.find("farmResource") != std::end(template_idata),
-                "farmResource at item[" + std::to_string(item_to_stake) + "] was not initialized. Contact to dev team");
-            check(template_idata.find("miningRate") != std::end(template_idata),
-                "miningRate at item[" + std::to_string(item_to_stake) + "] was not initialized. Contact to dev team");
-            check(template_idata.find("maxLevel") != std::end(template_idata),
-                "maxLevel at item[" + std::to_string(item_to_stake) + "] was not initialized. Contact to dev team");
-            
-            item_mdata["level"] = (uint8_t)1;
+            size_t item_end = entry.find(',', item_begin);
+            if(item_end == std::string::npos)
+                item_end = entry.size();
+
+            items.push_back(std::stoull(entry.substr(item_begin, item_end - item_begin)));
+            item_begin = item_end + 1;
         }
 
-        check(std::find(std::begin(stakeableResources), std::end(stakeableResources), std::get<std::string>(template_idata["farmResource"])) != std::end(stakeableResources),
-            "Item [" + std::to_string(item_to_stake) + "] can not be staked at current farming item");
-        update_mdata(asset_itr, item_mdata, get_self());
+        farmingitem_begin = farmingitem_end + 1;
     }
+    check(farmingitems.size() > 0, "Invalid memo");
 
-    staked_table.modify(staked_table_itr, get_self(), [&](auto &new_row)
+    return farmingitems;
+}
+
+
+void game::init_farmingitem(
+    atomicassets::assets_t::const_iterator& asset_itr,
+    asset_mdata& farmingitem_mdata,
+    const tmplcache_j& farmingitem_template_attrs
+)
+{
+    if(!farmingitem_mdata.slots.has_value())
     {
-        new_row.staked_items.insert(std::end(new_row.staked_items), std::begin(items_to_stake), std::end(items_to_stake));
-    });
+        check(farmingitem_template_attrs.maxSlots.has_value(),
+            "Farming item slots was not initialized. Contact ot dev team");
+        check(farmingitem_template_attrs.stakeableResources.has_value(),
+            "stakeableResources items at current farming item was not initialized. Contact to dev team");
+
+        farmingitem_mdata.slots = 1;
+        farmingitem_mdata.level = 1;
+
+        update_mdata(asset_itr, farmingitem_mdata, get_self());
+    }
+}
+
+
+void game::init_item(
+    atomicassets::assets_t::const_iterator& asset_itr,
+    const tmplcache_j& template_attrs,
+    const std::vector<std::string>& stakeableResources
+)
+{
+    arena::scope item_scope;
+    const uint64_t& item_to_stake = asset_itr->asset_id;
+    auto item_mdata = get_mdata(asset_itr);
+
+    item_mdata.lastClaim = current_time_point().sec_since_epoch();
+    if(!item_mdata.level.has_value())
+    {
+        // messages are built only on failure, they would be allocated for every staked item otherwise
+        if(!template_attrs.farmResource.has_value())
+            check(false, "farmResource at item[" + std::to_string(item_to_stake) + "] was not initialized. Contact to dev team");
+        if(!template_attrs.miningRate.has_value())
+            check(false, "miningRate at item[" + std::to_string(item_to_stake) + "] was not initialized. Contact to dev team");
+        if(!template_attrs.maxLevel.has_value())
+            check(false, "maxLevel at item[" + std::to_string(item_to_stake) + "] was not initialized. Contact to dev team");
+        
+        item_mdata.level = 1;
+    }
+
+    if(std::find(std::begin(stakeableResources), std::end(stakeableResources), template_attrs.farmResource.value()) == std::end(stakeableResources))
+        check(false, "Item [" + std::to_string(item_to_stake) + "] can not be staked at current farming item");
+    update_mdata(asset_itr, item_mdata, get_self());
 }
 
 
-void game::claim(const name& owner, const uint64_t& farmingitem)
+game::claim_result game::claim(const name& owner, const uint64_t& farmingitem)
 {
     require_auth(owner);
+    GAME_PROFILE_SCOPE("claim");
 
     staked_t staked_table(get_self(), owner.value);
     auto staked_table_itr = staked_table.require_find(farmingitem, "Could not find staked farming item");
-    auto assets = atomicassets::get_assets(get_self());
-    auto assets_itr = assets.find(farmingitem);
+    auto assets = get_assets(get_self());
 
-    //to get mining boost
-    auto farmingitem_mdata = get_mdata(assets_itr);
-    float miningBoost = 1;
-    if(farmingitem_mdata.find("miningBoost") != std::end(farmingitem_mdata))
-        miningBoost = std::get<float>(farmingitem_mdata["miningBoost"]);
-    
     // first - resource name, second - resource amount
     std::map<std::string, float> mined_resources;
     const uint32_t& time_now = current_time_point().sec_since_epoch();
-    for(const uint64_t& item_to_collect : staked_table_itr->staked_items)
+    const std::vector<uint64_t> staked_items = staked_table_itr->get_staked_items();
+    for(auto item_itr : atomicassets::find_assets(assets, staked_items))
     {
-        auto assets_itr           = assets.find(item_to_collect);
-        const std::pair<std::string, float> item_reward = claim_item(assets_itr, 2, time_now); // 2 is the percentage of increase in mine rate for each level
-
-        if(item_reward != std::pair<std::string,float>())
-            if(item_reward.second > 0)
-                mined_resources[item_reward.first] += item_reward.second;
+        const resource_reward item_reward = claim_item(item_itr, gamemath::upgrade_percentage, time_now);
+        if(item_reward.amount > 0)
+            mined_resources[*item_reward.resource] += item_reward.amount;
     }  
     check(mined_resources.size() > 0, "Nothing to claim");
 
-    increase_owner_resources_balance(owner, mined_resources);
+    claim_result result;
+    result.mined    = mined_resources;
+    result.balances = increase_owner_resources_balance(owner, mined_resources);
+    add_mined(owner, mined_resources);
+    log_claim(owner, farmingitem, time_now, mined_resources);
+
+    // worst case per item: its own schema, template and resource, none of them read before in this action
+    GAME_PROFILE_BUDGET(db_reads,       2 + staked_items.size() * 12);
+    GAME_PROFILE_BUDGET(db_writes,      staked_items.size() * 6);
+    GAME_PROFILE_BUDGET(decodes,        staked_items.size() * 2);
+    GAME_PROFILE_BUDGET(inline_actions, 1 + staked_items.size());
+
+    return result;
 }
 
-void game::upgradeitem(
+game::upgrade_result game::upgradeitem(
     const name& owner,
     const uint64_t& item_to_upgrade,
     const uint8_t& next_level,
@@ -146,117 +313,207 @@ void game::upgradeitem(
 )
 {
     require_auth(owner);
+    GAME_PROFILE_SCOPE("upgradeitem");
 
     const int32_t& time_now = current_time_point().sec_since_epoch();
 
-    auto assets     = atomicassets::get_assets(get_self());
+    auto assets     = get_assets(get_self());
     auto asset_itr  = assets.require_find(item_to_upgrade, ("Could not find staked item[" + std::to_string(item_to_upgrade) +"]").c_str());
 
     staked_t staked_table(get_self(), owner.value);
     auto staked_table_itr = staked_table.require_find(staked_at_farmingitem, "Could not find staked farming item");
 
-    check(std::find(std::begin(staked_table_itr->staked_items), std::end(staked_table_itr->staked_items), item_to_upgrade) != std::end(staked_table_itr->staked_items),
+    const std::vector<uint64_t> staked_items = staked_table_itr->get_staked_items();
+    check(std::find(std::begin(staked_items), std::end(staked_items), item_to_upgrade) != std::end(staked_items),
         "Item [" + std::to_string(item_to_upgrade) + "] is not staked at farming item");
 
-    //claiming mined resources before upgrade
-    const std::pair<std::string, float> item_reward = claim_item(asset_itr, 2, time_now); // 2 is the percentage of increase in mine rate for each level
-    if(item_reward != std::pair<std::string,float>())
-    {
-        if(item_reward.second > 0)
-        {
-            increase_owner_resources_balance(owner, std::map<std::string, float>({item_reward}));
-        }
-    }
+    //claiming mined resources before upgrade, they pay for the upgrade in the same balance write
+    std::map<std::string, float> claimed;
+    if(settles_rewards(owner))
+        claimed = claim_pending(owner, time_now, {item_to_upgrade}, assets);
+    const resource_reward item_reward = claim_item(asset_itr, gamemath::upgrade_percentage, time_now);
+    if(item_reward.amount > 0)
+        claimed[*item_reward.resource] += item_reward.amount;
+
     // upgrading
-    upgrade_item(asset_itr, 2, owner, next_level, time_now); // 2 is the percentage of increase in mine rate for each level
+    upgrade_result result = upgrade_item(asset_itr, gamemath::upgrade_percentage, owner, next_level, time_now, claimed);
+    result.claimed = claimed;
+    if(!claimed.empty())
+        add_mined(owner, claimed);
+
+    return result;
 }
 
-void game::upgrade_item(
+game::upgrade_result game::upgrade_item(
   atomicassets::assets_t::const_iterator& assets_itr,
   const uint8_t& upgrade_percentage,
   const name& owner,
   const uint8_t& new_level,
-  const uint32_t& time_now
+  const uint32_t& time_now,
+  const std::map<std::string, float>& claimed
 )
 {
-  auto mdata          = get_mdata(assets_itr);
-  auto template_idata = get_template_idata(assets_itr->template_id, assets_itr->collection_name);
+  auto mdata                = get_mdata(assets_itr);
+  const auto& template_attrs = get_template_attrs(assets_itr->template_id, assets_itr->collection_name);
 
-  const float& mining_rate   = std::get<float>(template_idata["miningRate"]);
-  const uint8_t& current_lvl = std::get<uint8_t>(mdata["level"]);
-  const std::string& resource_name = std::get<std::string>(template_idata["farmResource"]);
-  check(current_lvl < new_level, "New level must be higher then current level");
-  check(new_level <= std::get<uint8_t>(template_idata["maxLevel"]), "New level can not be higher then max level");
-  check(std::get<uint32_t>(mdata["lastClaim"]) < time_now, "Item is upgrading");
+  const std::pair<std::string, float> price = apply_item_upgrade(mdata, template_attrs, upgrade_percentage, new_level, time_now);
 
-  float miningRate_according2lvl = mining_rate;
-  for(uint8_t i = 1; i < new_level; ++i)
-    miningRate_according2lvl = miningRate_according2lvl + (miningRate_according2lvl * upgrade_percentage / 100);
+  upgrade_result result;
+  result.cost        = price.second;
+  result.level       = new_level;
+  result.upgraded_at = mdata.lastClaim.value();
+  result.balances    = net_owner_resources_balance(owner, claimed, std::map<std::string, float>({price}));
 
- 
-  const int32_t& upgrade_time  = get_upgrading_time(new_level) - get_upgrading_time(current_lvl);
-  const float& resource_price = upgrade_time * miningRate_according2lvl;
+  update_mdata(assets_itr, mdata, get_self());
 
-  std::get<uint8_t>(mdata["level"]) = new_level;
-  std::get<uint32_t>(mdata["lastClaim"]) = time_now + upgrade_time;
+  return result;
+}
 
-  reduce_owner_resources_balance(owner, std::map<std::string, float>({{resource_name, resource_price}}));
+const std::pair<std::string, float> game::apply_item_upgrade(
+  asset_mdata& mdata,
+  const tmplcache_j& template_attrs,
+  const uint8_t& upgrade_percentage,
+  const uint8_t& new_level,
+  const uint32_t& time_now
+)
+{
+  const float& mining_rate   = template_attrs.miningRate.value();
+  const uint8_t& current_lvl = mdata.level.value();
+  const std::string& resource_name = template_attrs.farmResource.value();
+  check(current_lvl < new_level, "New level must be higher then current level");
+  check(new_level <= template_attrs.maxLevel.value(), "New level can not be higher then max level");
+  check(mdata.lastClaim.value() < time_now, "Item is upgrading");
 
-  update_mdata(assets_itr, mdata, get_self());
-}
+  const int32_t upgrade_time  = gamemath::upgrade_time(current_lvl, new_level);
+  const float resource_price = gamemath::upgrade_cost(mining_rate, current_lvl, new_level, upgrade_percentage);
 
-const int32_t game::get_upgrading_time(const uint8_t& end_level)
-{ 
-  const int32_t increasing_time = 320; // 5.33 min
-  int32_t total_time = 0;
-  int32_t temp_tracker = 0;
-  for(uint8_t i = 2; i <= end_level; ++i)
-  {
-    if(i % 5 == 0)
-    {
-      total_time += (temp_tracker * 5);
-    }
-    else
-    {
-      temp_tracker += increasing_time;
-      total_time += increasing_time;
-    }
-  }
-  return total_time;
+  mdata.level     = new_level;
+  mdata.lastClaim = time_now + upgrade_time;
+
+  return std::make_pair(resource_name, resource_price);
 }
 
 void game::upgfarmitem(const name& owner, const uint64_t& farmingitem_to_upgrade, const bool& staked)
 {
     require_auth(owner);
+    GAME_PROFILE_SCOPE("upgfarmitem");
 
     if(staked)
     {
-        auto assets     = atomicassets::get_assets(get_self());
+        auto assets     = get_assets(get_self());
         auto asset_itr  = assets.require_find(farmingitem_to_upgrade, ("Could not find staked item[" + std::to_string(farmingitem_to_upgrade) +"]").c_str());
 
         staked_t staked_table(get_self(), owner.value);
         staked_table.require_find(farmingitem_to_upgrade, "Could not find staked farming item");
 
-        upgrade_farmingitem(asset_itr, get_self());
+        upgrade_farmingitem(asset_itr, get_self(), 1);
     }
     else
     {
-        auto assets     = atomicassets::get_assets(owner);
+        auto assets     = get_assets(owner);
         auto asset_itr  = assets.require_find(farmingitem_to_upgrade, ("You do not own farmingitem[" + std::to_string(farmingitem_to_upgrade) +"]").c_str());
-        upgrade_farmingitem(asset_itr, owner);
+        upgrade_farmingitem(asset_itr, owner, 1);
     }
 }
 
-void game::upgrade_farmingitem(atomicassets::assets_t::const_iterator& assets_itr, const name& owner)
+void game::upgrade_farmingitem(atomicassets::assets_t::const_iterator& assets_itr, const name& owner, const uint8_t& slots_to_add)
 {
-  auto mdata          = get_mdata(assets_itr);
-  auto template_idata = get_template_idata(assets_itr->template_id, assets_itr->collection_name);
+  auto mdata                = get_mdata(assets_itr);
+  const auto& template_attrs = get_template_attrs(assets_itr->template_id, assets_itr->collection_name);
 
-  check(std::get<uint8_t>(mdata["slots"])++ < std::get<uint8_t>(template_idata["maxSlots"]), "Farmingitem has max slots");
+  uint8_t& slots = mdata.slots.value();
+  check(slots + slots_to_add <= template_attrs.maxSlots.value(), "Farmingitem has max slots");
+  slots += slots_to_add;
 
   update_mdata(assets_itr, mdata, owner);
 }
 
+game::upgrademany_result game::upgrademany(
+  const name& owner,
+  const std::vector<item_upgrade>& items,
+  const std::vector<farmingitem_upgrade>& farmingitems
+)
+{
+  require_auth(owner);
+  GAME_PROFILE_SCOPE("upgrademany");
+
+  const uint32_t& time_now = current_time_point().sec_since_epoch();
+  upgrademany_result result;
+
+  auto assets = get_assets(get_self());
+  staked_t staked_table(get_self(), owner.value);
+
+  // mdata written by update_mdata is visible only after this action, so every asset is upgraded once
+  std::set<uint64_t> upgraded;
+  // farming item -> staked items, each staked row is read once
+  std::map<uint64_t, std::vector<uint64_t>> staked_items;
+  for(const item_upgrade& upgrade : items)
+  {
+    arena::scope item_scope;
+    // messages are built only on failure, they would be allocated for every item otherwise
+    if(!upgraded.insert(upgrade.item).second)
+      check(false, "Item [" + std::to_string(upgrade.item) + "] is listed twice");
+
+    auto staked_items_itr = staked_items.find(upgrade.staked_at_farmingitem);
+    if(staked_items_itr == std::end(staked_items))
+    {
+      auto staked_table_itr = staked_table.require_find(upgrade.staked_at_farmingitem, "Could not find staked farming item");
+      staked_items_itr = staked_items.emplace(upgrade.staked_at_farmingitem, staked_table_itr->get_staked_items()).first;
+    }
+    if(std::find(std::begin(staked_items_itr->second), std::end(staked_items_itr->second), upgrade.item) == std::end(staked_items_itr->second))
+      check(false, "Item [" + std::to_string(upgrade.item) + "] is not staked at farming item");
+
+    auto asset_itr = assets.find(upgrade.item);
+    if(asset_itr == std::end(assets))
+      check(false, "Could not find staked item[" + std::to_string(upgrade.item) + "]");
+    auto mdata                = get_mdata(asset_itr);
+    const auto& template_attrs = get_template_attrs(asset_itr->template_id, asset_itr->collection_name);
+
+    // claim and upgrade share one mdata write, upgrade sets lastClaim past time_now anyway
+    const resource_reward item_reward = get_item_reward(mdata, template_attrs, gamemath::upgrade_percentage, time_now);
+    if(item_reward.amount > 0)
+      result.claimed[*item_reward.resource] += item_reward.amount;
+
+    const std::pair<std::string, float> price = apply_item_upgrade(mdata, template_attrs, gamemath::upgrade_percentage, upgrade.next_level, time_now);
+    result.costs[price.first] += price.second;
+
+    update_mdata(asset_itr, mdata, get_self());
+  }
+
+  for(const farmingitem_upgrade& upgrade : farmingitems)
+  {
+    check(upgraded.insert(upgrade.farmingitem).second, "Farming item [" + std::to_string(upgrade.farmingitem) + "] is listed twice");
+    check(upgrade.slots_to_add > 0, "Slots to add must be positive");
+
+    if(upgrade.staked)
+    {
+      auto asset_itr  = assets.require_find(upgrade.farmingitem, ("Could not find staked item[" + std::to_string(upgrade.farmingitem) +"]").c_str());
+      staked_table.require_find(upgrade.farmingitem, "Could not find staked farming item");
+
+      upgrade_farmingitem(asset_itr, get_self(), upgrade.slots_to_add);
+    }
+    else
+    {
+      auto owner_assets = get_assets(owner);
+      auto asset_itr    = owner_assets.require_find(upgrade.farmingitem, ("You do not own farmingitem[" + std::to_string(upgrade.farmingitem) +"]").c_str());
+      upgrade_farmingitem(asset_itr, owner, upgrade.slots_to_add);
+    }
+  }
+
+  // upgraded items were claimed above, pending rewards of the other items are folded in
+  if(settles_rewards(owner))
+  {
+    for(const auto& pending : claim_pending(owner, time_now, upgraded, assets))
+      result.claimed[pending.first] += pending.second;
+  }
+
+  result.balances = net_owner_resources_balance(owner, result.claimed, result.costs);
+  if(!result.claimed.empty())
+    add_mined(owner, result.claimed);
+
+  return result;
+}
+
 void game::addblend(
   const std::vector<int32_t>  blend_components,
   const int32_t resulting_item
@@ -277,242 +534,1123 @@ void game::addblend(
 
 }
 
-void game::blend(const name& owner, const std::vector<uint64_t> asset_ids, const uint64_t& blend_id)
+void game::blend(const name& owner, const std::vector<uint64_t> asset_ids, const uint64_t& blend_id, const uint32_t& count)
 {
-    auto assets = atomicassets::get_assets(get_self());
-    auto templates = atomicassets::get_templates(get_self());
+    check(count > 0, "Blend count must be positive");
+
+    auto assets = get_assets(get_self());
+    auto templates = get_templates(get_self());
     blends_t blends_table(get_self(), get_self().value);
     auto blends_table_itr = blends_table.require_find(blend_id, "Could not find blend id");
-    check(blends_table_itr->blend_components.size() == asset_ids.size(), "Blend components count mismatch");
+    check(blends_table_itr->blend_components.size() * count == asset_ids.size(), "Blend components count mismatch");
+
+    // template id -> components still missing for all count blends
+    std::map<int32_t, uint64_t> missing_components;
+    for(const int32_t& component : blends_table_itr->blend_components)
+        missing_components[component] += count;
 
-    std::vector<int32_t> temp = blends_table_itr->blend_components;
-    for(const uint64_t& asset_id : asset_ids)
+    for(const auto& assets_itr : atomicassets::find_assets(assets, asset_ids))
     {
-        auto assets_itr = assets.find(asset_id);
+        const uint64_t& asset_id = assets_itr->asset_id;
         check(assets_itr->collection_name == name("collname"), // replace collection with your collection name to check for fake nfts
          ("Collection of asset [" + std::to_string(asset_id) + "] mismatch").c_str());
-        auto found =  std::find(std::begin(temp), std::end(temp), assets_itr->template_id);
-        if(found != std::end(temp))
-            temp.erase(found);
+        auto found = missing_components.find(assets_itr->template_id);
+        check(found != std::end(missing_components) && found->second > 0, "Invalid blend components");
+        --found->second;
         
-        action
+        send_action(atomicassets::ATOMICASSETS_ACCOUNT, "burnasset"_n, get_self(), asset_id);
+    }
+
+    auto templates_itr = templates.require_find(blends_table_itr->resulting_item, "Could not find resulting template");
+
+    const std::vector <asset> tokens_to_back = {};
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        send_action
         (
-            permission_level{get_self(),"active"_n},
             atomicassets::ATOMICASSETS_ACCOUNT,
-            "burnasset"_n,
-            std::make_tuple
-            (
-                get_self(),
-                asset_id
-            )
-        ).send();
-    }
-    check(temp.size() == 0, "Invalid blend components");
-
-    auto templates_itr = templates.find(blends_table_itr->resulting_item);
-
-    action
-    (
-        permission_level{get_self(),"active"_n},
-        atomicassets::ATOMICASSETS_ACCOUNT,
-        "mintasset"_n,
-        std::make_tuple
-        (
+            "mintasset"_n,
             get_self(),
             get_self(),
             templates_itr->schema_name,
             blends_table_itr->resulting_item,
             owner,
-            (atomicassets::ATTRIBUTE_MAP) {}, //immutable_data
-            (atomicassets::ATTRIBUTE_MAP) {}, //mutable data
-            (std::vector <asset>) {} // token back
-        )
-    ).send();
+            atomicdata::empty_map {}, //immutable_data
+            atomicdata::empty_map {}, //mutable data
+            tokens_to_back // token back
+        );
+    }
+
+    send_log("logblend"_n, owner, blend_id, count);
 }
 
-void game::setratio(const std::string& resource, const float& ratio)
+void game::packstaked(const name& owner)
 {
   require_auth(get_self());
 
-  const uint64_t key_id = stringToUint64(resource);
-  resourcecost_t resourcecost_table(get_self(), get_self().value);
-  auto resourcecost_table_itr = resourcecost_table.find(key_id);
+  staked_t staked_table(get_self(), owner.value);
+  for(auto staked_table_itr = std::begin(staked_table); staked_table_itr != std::end(staked_table); ++staked_table_itr)
+    pack_staked_row(staked_table, staked_table_itr);
+}
 
-  if(resourcecost_table_itr == std::end(resourcecost_table))
+bool game::pack_staked_row(staked_t& staked_table, staked_t::const_iterator& staked_table_itr)
+{
+  if(staked_table_itr->packed_items.has_value())
+    return false;
+
+  staked_table.modify(staked_table_itr, get_self(), [&](auto &new_row)
   {
-    resourcecost_table.emplace(get_self(), [&](auto &new_row)
-    {
-      new_row.key_id = key_id;
-      new_row.resource_name = resource;
-      new_row.ratio = ratio;
-    });
-  }
-  else
+    new_row.set_staked_items(new_row.staked_items);
+  });
+  return true;
+}
+
+void game::register_player(const name& owner)
+{
+  players_t players_table(get_self(), get_self().value);
+  if(players_table.find(owner.value) == std::end(players_table))
   {
-    resourcecost_table.modify(resourcecost_table_itr, get_self(), [&](auto &new_row)
+    players_table.emplace(get_self(), [&](auto &new_row)
     {
-      new_row.resource_name = resource;
-      new_row.ratio = ratio;
+      new_row.owner = owner;
     });
   }
 }
 
-void game::swap(const name& owner, const std::string& resource, const float& amount2swap)
+void game::addplayers(const std::vector<name>& owners, const bool& complete)
 {
-    require_auth(owner);
+  require_auth(get_self());
 
-    resourcecost_t resourcecost_table(get_self(), get_self().value);
-    auto resourcecost_table_itr = resourcecost_table.require_find(stringToUint64(resource), "Could not find resource cost config");
+  for(const name& owner : owners)
+    register_player(owner);
 
-    const float token_amount = amount2swap / resourcecost_table_itr->ratio;
-    const asset tokens2receive = asset(token_amount * 10000, symbol("GAME", 4)); // change to token you have deployed
-    
-    reduce_owner_resources_balance(owner, std::map<std::string, float>({{resource, amount2swap}}));
-    tokens_transfer(owner, tokens2receive);
+  if(complete)
+  {
+    config_t config(get_self(), get_self().value);
+    config_j new_config = config.get_or_default();
+    // extensions are packed in order, an earlier missing one would drop this one
+    new_config.queue_swaps.emplace(new_config.queue_swaps.value_or(false));
+    new_config.players_complete.emplace(true);
+    config.set(new_config, get_self());
+  }
 }
 
-void game::tokens_transfer(const name& to, const asset& quantity)
+void game::startmigr(const name& migration)
 {
+  require_auth(get_self());
 
-  action
-  (
-    permission_level{get_self(),"active"_n},
-    "tokencontr"_n, // change to your deployed token contract
-    "transfer"_n,
-    std::make_tuple
-    (
-      get_self(),
-      to,
-      quantity,
-      std::string("")
-    )
-  ).send();
+  migration_t migration_singleton(get_self(), get_self().value);
+  check(migration_singleton.get_or_default().migration == name(), "Another migration is running");
+  check(migration == "packstaked"_n, "Unknown migration");
+
+  migration_j cursor{};
+  cursor.migration = migration;
+  migration_singleton.set(cursor, get_self());
 }
 
-const std::pair<std::string, float> game::claim_item(atomicassets::assets_t::const_iterator& assets_itr, const uint8_t& upgrade_percentage, const uint32_t& time_now)
+void game::migrate(const uint32_t& batch_size)
 {
-  auto item_mdata           = get_mdata(assets_itr);
-  const uint32_t& lastClaim = std::get<uint32_t>(item_mdata["lastClaim"]);
-  std::pair<std::string, float> mined_resource;
+  require_auth(get_self());
+  check(batch_size > 0, "Batch size must be positive");
 
-  if(time_now > lastClaim)
-  {
-    auto item_template_idata        = get_template_idata(assets_itr->template_id, assets_itr->collection_name);
-    const float& miningRate         = std::get<float>(item_template_idata["miningRate"]);
-    const std::string& farmResource = std::get<std::string>(item_template_idata["farmResource"]);
-    const uint8_t&  current_lvl     = std::get<uint8_t>(item_mdata["level"]);
+  migration_t migration_singleton(get_self(), get_self().value);
+  migration_j cursor = migration_singleton.get_or_default();
+  check(cursor.migration != name(), "No migration is running");
 
-    //calculate mining rate according to lvl
-    float miningRate_according2lvl = miningRate;
-    for(uint8_t i = 1; i < current_lvl; ++i)
-        miningRate_according2lvl = miningRate_according2lvl + (miningRate_according2lvl * upgrade_percentage / 100);
+  players_t players_table(get_self(), get_self().value);
+  auto players_table_itr = players_table.lower_bound(cursor.scope);
+  uint32_t budget = batch_size;
+  while(players_table_itr != std::end(players_table))
+  {
+    // player of saved cursor may have been removed meanwhile
+    if(players_table_itr->owner.value != cursor.scope)
+    {
+      cursor.scope    = players_table_itr->owner.value;
+      cursor.next_key = 0;
+    }
 
-    const float& reward = (time_now - lastClaim) * miningRate_according2lvl;
-    item_mdata["lastClaim"] = time_now;
-    update_mdata(assets_itr, item_mdata, get_self());
+    if(!migrate_scope(cursor, players_table_itr->owner, budget))
+      break;
 
-    mined_resource.first = farmResource;
-    mined_resource.second = reward;
+    ++cursor.scopes_done;
+    ++players_table_itr;
+    cursor.next_key = 0;
+    if(players_table_itr != std::end(players_table))
+      cursor.scope = players_table_itr->owner.value;
   }
 
-  return mined_resource;
+  if(players_table_itr == std::end(players_table))
+    cursor.migration = name();
+
+  migration_singleton.set(cursor, get_self());
 }
 
-void game::increase_owner_resources_balance(const name& owner, const std::map<std::string, float>& resources)
+bool game::migrate_scope(migration_j& cursor, const name& owner, uint32_t& budget)
 {
-  resources_t resources_table(get_self(), owner.value);
-  for(const auto& map_itr : resources)
+  if(cursor.migration == "packstaked"_n)
   {
-    const uint64_t& key_id = stringToUint64(map_itr.first);
-
-    auto resources_table_itr = resources_table.find(key_id);
-    if(resources_table_itr == std::end(resources_table))
-    {
-      resources_table.emplace(get_self(), [&](auto &new_row)
-      {
-        new_row.key_id          = key_id;
-        new_row.resource_name   = map_itr.first;
-        new_row.amount          = map_itr.second;
-      });
-    }
-    else
+    staked_t staked_table(get_self(), owner.value);
+    for(auto staked_table_itr = staked_table.lower_bound(cursor.next_key); staked_table_itr != std::end(staked_table); ++staked_table_itr)
     {
-      resources_table.modify(resources_table_itr, get_self(), [&](auto &new_row)
+      if(budget == 0)
       {
-        new_row.amount += map_itr.second;
-      });
+        cursor.next_key = staked_table_itr->asset_id;
+        return false;
+      }
+      --budget;
+
+      if(pack_staked_row(staked_table, staked_table_itr))
+        ++cursor.rows_migrated;
+      else
+        ++cursor.rows_skipped;
     }
+    return true;
   }
+
+  check(false, "Unknown migration");
+  return false;
 }
 
-void game::reduce_owner_resources_balance(const name& owner, const std::map<std::string, float>& resources)
+std::vector<uint64_t> game::staked_j::get_staked_items() const
 {
-  resources_t resources_table(get_self(), owner.value);
-
-  for(const auto& map_itr : resources)
+  if(!packed_items.has_value())
+    return staked_items;
+
+  std::vector<uint64_t> items;
+  uint64_t item  = 0;
+  uint64_t delta = 0;
+  uint8_t  shift = 0;
+  for(const uint8_t& byte : packed_items.value())
   {
-    const uint64_t& key_id = stringToUint64(map_itr.first);
-    auto resources_table_itr = resources_table.require_find(key_id,
-      ("Could not find balance of " + map_itr.first).c_str());
-    check(resources_table_itr->amount >= map_itr.second, ("Overdrawn balance: " + map_itr.first).c_str());
-
-    if(resources_table_itr->amount == map_itr.second)
-      resources_table.erase(resources_table_itr);
-    else
+    delta |= (uint64_t)(byte & 0x7f) << shift;
+    if(byte & 0x80)
     {
-      resources_table.modify(resources_table_itr, get_self(), [&](auto &new_row)
-      {
-        new_row.amount -= map_itr.second;
-      });
+      shift += 7;
+      continue;
     }
+
+    item += delta;
+    items.push_back(item);
+    delta = 0;
+    shift = 0;
   }
+  return items;
 }
 
+void game::staked_j::set_staked_items(std::vector<uint64_t> items)
+{
+  std::sort(std::begin(items), std::end(items));
+
+  std::vector<uint8_t> packed;
+  uint64_t previous = 0;
+  for(const uint64_t& item : items)
+  {
+    const std::vector<uint8_t> bytes = atomicdata::toVarintBytes(item - previous);
+    packed.insert(std::end(packed), std::begin(bytes), std::end(bytes));
+    previous = item;
+  }
+
+  staked_items.clear();
+  packed_items.emplace(packed);
+}
 
-atomicassets::ATTRIBUTE_MAP game::get_mdata(atomicassets::assets_t::const_iterator& assets_itr)
+void game::setlogs(const bool& enabled)
 {
-  auto schemas = atomicassets::get_schemas(assets_itr->collection_name);
-  auto schema_itr = schemas.find(assets_itr->schema_name.value);
+  require_auth(get_self());
 
-  atomicassets::ATTRIBUTE_MAP deserialized_mdata = atomicdata::deserialize             
-  (
-    assets_itr->mutable_serialized_data,
-    schema_itr->format
-  );
+  config_t config(get_self(), get_self().value);
+  config_j new_config = config.get_or_default();
+  new_config.emit_logs = enabled;
+  config.set(new_config, get_self());
+}
 
-  return deserialized_mdata;
+const game::config_j& game::get_game_config()
+{
+  if(!game_config.has_value())
+  {
+    config_t config(get_self(), get_self().value);
+    game_config = config.get_or_default();
+  }
+  return game_config.value();
 }
 
-atomicassets::ATTRIBUTE_MAP game::get_template_idata(const int32_t& template_id, const name& collection_name)
+void game::logclaim(const name&, const uint64_t&, const uint32_t&, const std::vector<log_amount>&)
 {
-  auto templates = atomicassets::get_templates(collection_name);
-  auto template_itr = templates.find(template_id);
+  require_auth(get_self());
+}
 
-  auto schemas = atomicassets::get_schemas(collection_name);
-  auto schema_itr = schemas.find(template_itr->schema_name.value);
+void game::logswap(const name&, const uint64_t&, const float&, const asset&)
+{
+  require_auth(get_self());
+}
 
-  return atomicdata::deserialize             
-  (
-    template_itr->immutable_serialized_data,
-    schema_itr->format
-  );
+void game::logstake(const name&, const uint64_t&, const std::vector<uint64_t>&)
+{
+  require_auth(get_self());
 }
 
-void game::update_mdata(atomicassets::assets_t::const_iterator& assets_itr, const atomicassets::ATTRIBUTE_MAP& new_mdata, const name& owner)
+void game::logblend(const name&, const uint64_t&, const uint32_t&)
 {
-  action
-  (
-    permission_level{get_self(),"active"_n},
-    atomicassets::ATOMICASSETS_ACCOUNT,
-    "setassetdata"_n,
-    std::make_tuple
-    (
-      get_self(),
-      owner,
-      assets_itr->asset_id,
-      new_mdata
-    )
-  ).send();
+  require_auth(get_self());
+}
+
+void game::refreshtmpl(const name& collection_name, const int32_t& template_id)
+{
+  require_auth(get_self());
+
+  tmplcache_t tmplcache_table(get_self(), collection_name.value);
+  auto tmplcache_table_itr = tmplcache_table.require_find(template_id, "Template is not cached");
+  tmplcache_table.erase(tmplcache_table_itr);
+}
+
+void game::setratio(const std::string& resource, const float& ratio)
+{
+  require_auth(get_self());
+
+  const uint64_t key_id = stringToUint64(resource);
+  resourcecost_t resourcecost_table(get_self(), get_self().value);
+  auto resourcecost_table_itr = resourcecost_table.find(key_id);
+
+  if(resourcecost_table_itr == std::end(resourcecost_table))
+  {
+    resourcecost_table.emplace(get_self(), [&](auto &new_row)
+    {
+      new_row.key_id = key_id;
+      new_row.resource_name = resource;
+      new_row.ratio = ratio;
+    });
+  }
+  else
+  {
+    resourcecost_table.modify(resourcecost_table_itr, get_self(), [&](auto &new_row)
+    {
+      new_row.resource_name = resource;
+      new_row.ratio = ratio;
+    });
+  }
+}
+
+game::swap_result game::swap(const name& owner, const std::string& resource, const float& amount2swap)
+{
+    require_auth(owner);
+    GAME_PROFILE_SCOPE("swap");
+
+    resourcecost_t resourcecost_table(get_self(), get_self().value);
+    auto resourcecost_table_itr = resourcecost_table.require_find(stringToUint64(resource), "Could not find resource cost config");
+
+    const char* swap_error = gamemath::swap_error(amount2swap, resourcecost_table_itr->ratio);
+    check(swap_error == nullptr, swap_error);
+    const asset tokens2receive = get_swap_quote(amount2swap, resourcecost_table_itr->ratio);
+    
+    // pending rewards are claimed first and pay for the swap in the same balance write
+    std::map<std::string, float> claimed;
+    if(settles_rewards(owner))
+        claimed = claim_pending(owner, current_time_point().sec_since_epoch(), {}, get_assets(get_self()));
+
+    swap_result result;
+    result.tokens  = tokens2receive;
+    result.balance = net_owner_resources_balance(owner, claimed, std::map<std::string, float>({{resource, amount2swap}}))[resource];
+    if(!claimed.empty())
+        add_mined(owner, claimed);
+    add_stat("swapped"_n, resourcecost_table_itr->key_id, resource, amount2swap);
+
+    if(get_game_config().queue_swaps.value_or(false))
+    {
+        orders_t orders_table(get_self(), get_self().value);
+        result.tokens.amount = 0;
+        result.order_id      = orders_table.available_primary_key();
+
+        orders_table.emplace(get_self(), [&](auto &new_row)
+        {
+            new_row.id           = result.order_id.value();
+            new_row.owner        = owner;
+            new_row.resource_key = resourcecost_table_itr->key_id;
+            new_row.amount       = amount2swap;
+            new_row.tokens       = tokens2receive;
+        });
+        return result;
+    }
+
+    result.token_balance = credit_tokens(owner, tokens2receive);
+
+    send_log("logswap"_n, owner, stringToUint64(resource), amount2swap, tokens2receive);
+
+    return result;
+}
+
+void game::setswapmode(const bool& queued)
+{
+  require_auth(get_self());
+
+  config_t config(get_self(), get_self().value);
+  config_j new_config = config.get_or_default();
+  new_config.queue_swaps.emplace(queued);
+  config.set(new_config, get_self());
+}
+
+void game::settle(const uint32_t& max_orders)
+{
+    GAME_PROFILE_SCOPE("settle");
+    check(max_orders > 0, "max_orders must be positive");
+
+    // resources and quoted tokens per resource and owner, orders of one owner are paid together
+    std::map<uint64_t, std::map<name, std::pair<float, asset>>> amounts;
+    orders_t orders_table(get_self(), get_self().value);
+    uint32_t settled = 0;
+    for(auto orders_table_itr = std::begin(orders_table); orders_table_itr != std::end(orders_table) && settled < max_orders; ++settled)
+    {
+        auto& owner_amounts = amounts[orders_table_itr->resource_key];
+        auto owner_amounts_itr = owner_amounts.find(orders_table_itr->owner);
+        if(owner_amounts_itr == std::end(owner_amounts))
+            owner_amounts.emplace(orders_table_itr->owner, std::make_pair(orders_table_itr->amount, orders_table_itr->tokens));
+        else
+        {
+            owner_amounts_itr->second.first  += orders_table_itr->amount;
+            owner_amounts_itr->second.second += orders_table_itr->tokens;
+        }
+        orders_table_itr = orders_table.erase(orders_table_itr);
+    }
+    check(settled > 0, "No orders to settle");
+
+    // swap rejects quotes of no tokens, so every payout is positive
+    std::map<name, asset> payouts;
+    for(const auto& resource_amounts : amounts)
+    {
+        for(const auto& owner_amount : resource_amounts.second)
+        {
+            const asset& tokens = owner_amount.second.second;
+            auto payouts_itr = payouts.find(owner_amount.first);
+            if(payouts_itr == std::end(payouts))
+                payouts.emplace(owner_amount.first, tokens);
+            else
+                payouts_itr->second += tokens;
+
+            send_log("logswap"_n, owner_amount.first, resource_amounts.first, owner_amount.second.first, tokens);
+        }
+    }
+
+    for(const auto& payout : payouts)
+        credit_tokens(payout.first, payout.second);
+}
+
+void game::withdraw(const name& owner, const asset& quantity)
+{
+    require_auth(owner);
+    check(quantity.is_valid(), "Invalid quantity");
+    check(quantity.amount > 0, "Quantity must be positive");
+
+    ledger_t ledger_table(get_self(), owner.value);
+    auto ledger_table_itr = ledger_table.require_find(quantity.symbol.code().raw(), "No token balance to withdraw");
+    check(ledger_table_itr->balance.symbol == quantity.symbol, "Symbol precision mismatch");
+    check(ledger_table_itr->balance >= quantity, "Overdrawn token balance");
+
+    if(ledger_table_itr->balance == quantity)
+    {
+        ledger_table.erase(ledger_table_itr);
+    }
+    else
+    {
+        ledger_table.modify(ledger_table_itr, get_self(), [&](auto &new_row)
+        {
+            new_row.balance -= quantity;
+        });
+    }
+
+    tokens_transfer(owner, quantity);
+}
+
+asset game::credit_tokens(const name& owner, const asset& quantity)
+{
+    check(quantity.amount > 0, "Credited tokens must be positive");
+
+    double tokens = quantity.amount;
+    for(uint8_t i = 0; i < quantity.symbol.precision(); ++i)
+        tokens /= 10;
+    add_stat("tokens"_n, quantity.symbol.code().raw(), quantity.symbol.code().to_string(), tokens);
+
+    ledger_t ledger_table(get_self(), owner.value);
+    auto ledger_table_itr = ledger_table.find(quantity.symbol.code().raw());
+
+    if(ledger_table_itr == std::end(ledger_table))
+    {
+        ledger_table.emplace(get_self(), [&](auto &new_row)
+        {
+            new_row.balance = quantity;
+        });
+        return quantity;
+    }
+
+    ledger_table.modify(ledger_table_itr, get_self(), [&](auto &new_row)
+    {
+        new_row.balance += quantity;
+    });
+    return ledger_table_itr->balance;
+}
+
+const asset game::get_swap_quote(const float& amount2swap, const float& ratio)
+{
+  return asset(gamemath::swap_amount(amount2swap, ratio), symbol("GAME", 4)); // change to token you have deployed
+}
+
+game::dashboard game::getdashboard(const name& owner)
+{
+  GAME_PROFILE_SCOPE("getdashboard");
+  dashboard result;
+  const uint32_t& time_now = current_time_point().sec_since_epoch();
+
+  auto assets = get_assets(get_self());
+  staked_t staked_table(get_self(), owner.value);
+  for(const auto& staked : staked_table)
+  {
+    auto assets_itr        = assets.find(staked.asset_id);
+    if(assets_itr == std::end(assets))
+      check(false, "Could not find farming item[" + std::to_string(staked.asset_id) + "]");
+    auto farmingitem_mdata = get_mdata(assets_itr);
+
+    dashboard_farm farm;
+    farm.farmingitem  = staked.asset_id;
+    farm.slots        = farmingitem_mdata.slots.value();
+    farm.staked_items = staked.get_staked_items();
+
+    for(const uint64_t& item : farm.staked_items)
+    {
+      arena::scope item_scope;
+      auto item_itr             = assets.find(item);
+      if(item_itr == std::end(assets))
+        check(false, "Could not find staked item[" + std::to_string(item) + "]");
+      auto item_mdata           = get_mdata(item_itr);
+      const auto& template_attrs = find_template_attrs(item_itr->template_id, item_itr->collection_name);
+      const resource_reward item_reward = get_item_reward(item_mdata, template_attrs, gamemath::upgrade_percentage, time_now);
+
+      if(item_reward.amount > 0)
+        farm.pending_rewards[*item_reward.resource] += item_reward.amount;
+    }
+    result.farms.push_back(farm);
+  }
+
+  resources_t resources_table(get_self(), owner.value);
+  resourcecost_t resourcecost_table(get_self(), get_self().value);
+  for(const auto& resource : resources_table)
+  {
+    dashboard_balance balance;
+    balance.resource_name = resource.resource_name;
+    balance.amount        = resource.amount;
+    balance.swap_quote    = asset(0, symbol("GAME", 4));
+
+    auto resourcecost_table_itr = resourcecost_table.find(resource.key_id);
+    if(resourcecost_table_itr != std::end(resourcecost_table))
+      balance.swap_quote = get_swap_quote(resource.amount, resourcecost_table_itr->ratio);
+
+    result.balances.push_back(balance);
+  }
+
+  return result;
+}
+
+void game::tokens_transfer(const name& to, const asset& quantity)
+{
+  send_action
+  (
+    "tokencontr"_n, // change to your deployed token contract
+    "transfer"_n,
+    get_self(),
+    to,
+    quantity,
+    std::string("")
+  );
+}
+
+game::resource_reward game::claim_item(atomicassets::assets_t::const_iterator& assets_itr, const uint8_t& upgrade_percentage, const uint32_t& time_now)
+{
+  arena::scope item_scope;
+  auto item_mdata = get_mdata(assets_itr);
+  resource_reward mined_resource;
+
+  if(time_now > item_mdata.lastClaim.value())
+  {
+    const auto& template_attrs = get_template_attrs(assets_itr->template_id, assets_itr->collection_name);
+    mined_resource = get_item_reward(item_mdata, template_attrs, upgrade_percentage, time_now);
+
+    item_mdata.lastClaim = time_now;
+    update_mdata(assets_itr, item_mdata, get_self());
+  }
+
+  return mined_resource;
+}
+
+game::resource_reward game::get_item_reward(
+  const asset_mdata& item_mdata,
+  const tmplcache_j& template_attrs,
+  const uint8_t& upgrade_percentage,
+  const uint32_t& time_now
+)
+{
+  const uint32_t& lastClaim = item_mdata.lastClaim.value();
+  resource_reward mined_resource;
+
+  if(time_now > lastClaim)
+  {
+    const float& miningRate         = template_attrs.miningRate.value();
+    const std::string& farmResource = template_attrs.farmResource.value();
+    const uint8_t&  current_lvl     = item_mdata.level.value();
+
+    mined_resource.resource = &farmResource;
+    mined_resource.amount   = gamemath::reward(miningRate, current_lvl, upgrade_percentage, lastClaim, time_now);
+  }
+
+  return mined_resource;
+}
+
+std::map<std::string, float> game::claim_pending(
+  const name& owner,
+  const uint32_t& time_now,
+  const std::set<uint64_t>& skip_items,
+  const assets_t& assets
+)
+{
+  std::map<std::string, float> claimed;
+  staked_t staked_table(get_self(), owner.value);
+  for(const auto& staked : staked_table)
+  {
+    std::vector<uint64_t> items_to_collect;
+    for(const uint64_t& item_to_collect : staked.get_staked_items())
+    {
+      if(skip_items.count(item_to_collect) == 0)
+        items_to_collect.push_back(item_to_collect);
+    }
+
+    std::map<std::string, float> mined_resources;
+    for(auto item_itr : atomicassets::find_assets(assets, items_to_collect))
+    {
+      const resource_reward item_reward = claim_item(item_itr, gamemath::upgrade_percentage, time_now);
+      if(item_reward.amount > 0)
+        mined_resources[*item_reward.resource] += item_reward.amount;
+    }
+    if(mined_resources.empty())
+      continue;
+
+    log_claim(owner, staked.asset_id, time_now, mined_resources);
+    for(const auto& mined_resource : mined_resources)
+      claimed[mined_resource.first] += mined_resource.second;
+  }
+
+  return claimed;
+}
+
+void game::setautoclaim(const name& owner, const bool& enabled)
+{
+  require_auth(owner);
+
+  autoclaim_t autoclaim_table(get_self(), get_self().value);
+  auto autoclaim_table_itr = autoclaim_table.find(owner.value);
+  if(enabled)
+  {
+    check(autoclaim_table_itr == std::end(autoclaim_table), "Auto-claim is already on");
+    autoclaim_table.emplace(owner, [&](auto &new_row)
+    {
+      new_row.owner = owner;
+    });
+  }
+  else
+  {
+    check(autoclaim_table_itr != std::end(autoclaim_table), "Auto-claim is already off");
+    autoclaim_table.erase(autoclaim_table_itr);
+  }
+}
+
+void game::crank(const uint32_t& max_owners)
+{
+  require_auth(get_self());
+  GAME_PROFILE_SCOPE("crank");
+  check(max_owners > 0, "max_owners must be positive");
+
+  autoclaim_t autoclaim_table(get_self(), get_self().value);
+  check(std::begin(autoclaim_table) != std::end(autoclaim_table), "No owners to claim for");
+
+  crank_t crank_singleton(get_self(), get_self().value);
+  crank_j cursor = crank_singleton.get_or_default();
+
+  // one assets table and the template and schema caches serve every owner of the crank
+  auto assets = get_assets(get_self());
+  const uint32_t& time_now = current_time_point().sec_since_epoch();
+
+  auto autoclaim_table_itr = autoclaim_table.lower_bound(cursor.next_owner);
+  for(uint32_t processed = 0; processed < max_owners; ++processed)
+  {
+    // continue from the first owner, each owner is claimed at most once per crank
+    if(autoclaim_table_itr == std::end(autoclaim_table))
+      autoclaim_table_itr = std::begin(autoclaim_table);
+    if(processed > 0 && autoclaim_table_itr->owner.value == cursor.next_owner)
+      break;
+    if(processed == 0)
+      cursor.next_owner = autoclaim_table_itr->owner.value;
+
+    const name owner = autoclaim_table_itr->owner;
+    const std::map<std::string, float> claimed = claim_pending(owner, time_now, {}, assets);
+    if(!claimed.empty())
+    {
+      increase_owner_resources_balance(owner, claimed);
+      add_mined(owner, claimed);
+    }
+    ++autoclaim_table_itr;
+  }
+
+  cursor.next_owner = autoclaim_table_itr == std::end(autoclaim_table) ? 0 : autoclaim_table_itr->owner.value;
+  crank_singleton.set(cursor, get_self());
+}
+
+void game::log_claim(const name& owner, const uint64_t& farmingitem, const uint32_t& time_now, const std::map<std::string, float>& mined_resources)
+{
+  std::vector<log_amount> mined;
+  for(const auto& mined_resource : mined_resources)
+    mined.push_back({stringToUint64(mined_resource.first), mined_resource.second});
+  send_log("logclaim"_n, owner, farmingitem, time_now, mined);
+}
+
+bool game::settles_rewards(const name& owner)
+{
+  settings_t settings(get_self(), owner.value);
+  return settings.get_or_default().settle_rewards;
+}
+
+void game::setsettle(const name& owner, const bool& enabled)
+{
+  require_auth(owner);
+
+  settings_t settings(get_self(), owner.value);
+  settings_j new_settings = settings.get_or_default();
+  new_settings.settle_rewards = enabled;
+  settings.set(new_settings, owner);
+}
+
+std::map<std::string, float> game::net_owner_resources_balance(
+  const name& owner,
+  const std::map<std::string, float>& credit,
+  const std::map<std::string, float>& debit
+)
+{
+  // credit pays for debit of the same resource first, so every resource balance is written once
+  std::map<std::string, float> increase = credit;
+  std::map<std::string, float> reduce;
+  std::vector<std::string> netted;
+  for(const auto& cost : debit)
+  {
+    auto increase_itr = increase.find(cost.first);
+    if(increase_itr == std::end(increase))
+      reduce[cost.first] = cost.second;
+    else if(increase_itr->second > cost.second)
+      increase_itr->second -= cost.second;
+    else
+    {
+      if(increase_itr->second < cost.second)
+        reduce[cost.first] = cost.second - increase_itr->second;
+      else
+        netted.push_back(cost.first);
+      increase.erase(increase_itr);
+    }
+  }
+
+  std::map<std::string, float> balances;
+  if(!increase.empty())
+    balances = increase_owner_resources_balance(owner, increase);
+  if(!reduce.empty())
+  {
+    const std::map<std::string, float> reduced = reduce_owner_resources_balance(owner, reduce);
+    balances.insert(std::begin(reduced), std::end(reduced));
+  }
+  if(!netted.empty())
+  {
+    // nothing to write, report the unchanged balances
+    resources_t resources_table(get_self(), owner.value);
+    for(const std::string& resource : netted)
+    {
+      auto resources_table_itr = resources_table.find(stringToUint64(resource));
+      balances[resource] = resources_table_itr == std::end(resources_table) ? 0 : resources_table_itr->amount;
+    }
+  }
+
+  return balances;
+}
+
+std::map<std::string, float> game::increase_owner_resources_balance(const name& owner, const std::map<std::string, float>& resources)
+{
+  std::map<std::string, float> balances;
+  resources_t resources_table(get_self(), owner.value);
+  for(const auto& map_itr : resources)
+  {
+    const uint64_t& key_id = stringToUint64(map_itr.first);
+
+    auto resources_table_itr = resources_table.find(key_id);
+    if(resources_table_itr == std::end(resources_table))
+    {
+      resources_table.emplace(get_self(), [&](auto &new_row)
+      {
+        new_row.key_id          = key_id;
+        new_row.resource_name   = map_itr.first;
+        new_row.amount          = map_itr.second;
+      });
+    }
+    else
+    {
+      resources_table.modify(resources_table_itr, get_self(), [&](auto &new_row)
+      {
+        new_row.amount += map_itr.second;
+      });
+    }
+    balances[map_itr.first] = resources_table_itr == std::end(resources_table) ? map_itr.second : resources_table_itr->amount;
+  }
+
+  return balances;
+}
+
+void game::add_mined(const name& owner, const std::map<std::string, float>& mined)
+{
+  mined_t mined_table(get_self(), owner.value);
+  for(const auto& map_itr : mined)
+  {
+    const uint64_t& key_id = stringToUint64(map_itr.first);
+    auto mined_table_itr = mined_table.find(key_id);
+
+    double total = map_itr.second;
+    if(mined_table_itr == std::end(mined_table))
+    {
+      mined_table.emplace(get_self(), [&](auto &new_row)
+      {
+        new_row.key_id = key_id;
+        new_row.total  = total;
+      });
+    }
+    else
+    {
+      mined_table.modify(mined_table_itr, get_self(), [&](auto &new_row)
+      {
+        new_row.total += map_itr.second;
+      });
+      total = mined_table_itr->total;
+    }
+
+    update_leaderboard(owner, key_id, total);
+    add_stat("emitted"_n, key_id, map_itr.first, map_itr.second);
+  }
+}
+
+void game::add_stat(const name& metric, const uint64_t& key, const std::string& label, const double& amount)
+{
+  stats_t stats_table(get_self(), metric.value);
+  auto stats_table_itr = stats_table.find(key);
+
+  if(stats_table_itr == std::end(stats_table))
+  {
+    stats_table.emplace(get_self(), [&](auto &new_row)
+    {
+      new_row.key   = key;
+      new_row.label = label;
+      new_row.total = amount;
+    });
+  }
+  else
+  {
+    stats_table.modify(stats_table_itr, get_self(), [&](auto &new_row)
+    {
+      new_row.total += amount;
+    });
+  }
+}
+
+std::vector<game::stat> game::get_stats(const name& metric)
+{
+  std::vector<stat> result;
+  stats_t stats_table(get_self(), metric.value);
+  for(const auto& row : stats_table)
+    result.push_back({row.label, row.total});
+  return result;
+}
+
+game::stats game::getstats()
+{
+  stats result;
+  result.emitted     = get_stats("emitted"_n);
+  result.swapped     = get_stats("swapped"_n);
+  result.tokens_paid = get_stats("tokens"_n);
+  result.staked      = get_stats("staked"_n);
+  return result;
+}
+
+void game::update_leaderboard(const name& owner, const uint64_t& resource_key, const double& total)
+{
+  leaders_t leaders_table(get_self(), get_self().value);
+  auto leaders_by_owner = leaders_table.get_index<"byowner"_n>();
+  auto leader_itr = leaders_by_owner.find((uint128_t(resource_key) << 64) | owner.value);
+  if(leader_itr != std::end(leaders_by_owner))
+  {
+    leaders_by_owner.modify(leader_itr, get_self(), [&](auto &new_row)
+    {
+      new_row.total = total;
+    });
+    return;
+  }
+
+  boards_t boards_table(get_self(), get_self().value);
+  auto boards_table_itr = boards_table.find(resource_key);
+
+  if(boards_table_itr == std::end(boards_table))
+  {
+    boards_table.emplace(get_self(), [&](auto &new_row)
+    {
+      new_row.resource_key = resource_key;
+      new_row.size         = 1;
+    });
+  }
+  else if(boards_table_itr->size < leaderboard_size)
+  {
+    boards_table.modify(boards_table_itr, get_self(), [&](auto &new_row)
+    {
+      new_row.size += 1;
+    });
+  }
+  else
+  {
+    // board is full, owner replaces the lowest total if it has mined more
+    auto leaders_by_total = leaders_table.get_index<"bytotal"_n>();
+    auto lowest_itr = leaders_by_total.lower_bound(uint128_t(resource_key) << 64);
+    if(lowest_itr->total >= total)
+      return;
+    leaders_by_total.erase(lowest_itr);
+  }
+
+  leaders_table.emplace(get_self(), [&](auto &new_row)
+  {
+    new_row.id           = leaders_table.available_primary_key();
+    new_row.resource_key = resource_key;
+    new_row.owner        = owner;
+    new_row.total        = total;
+  });
+}
+
+std::vector<game::leader> game::getleaders(const std::string& resource, const uint32_t& limit)
+{
+  std::vector<leader> result;
+  const uint64_t resource_key = stringToUint64(resource);
+
+  leaders_t leaders_table(get_self(), get_self().value);
+  auto leaders_by_total = leaders_table.get_index<"bytotal"_n>();
+  auto leader_itr = leaders_by_total.upper_bound((uint128_t(resource_key) << 64) | UINT64_MAX);
+  while(result.size() < limit && leader_itr != std::begin(leaders_by_total))
+  {
+    --leader_itr;
+    if(leader_itr->resource_key != resource_key)
+      break;
+    result.push_back({leader_itr->owner, leader_itr->total});
+  }
+
+  return result;
+}
+
+game::export_page game::exportstate(const export_cursor& cursor, const uint32_t& limit)
+{
+  check(limit > 0 && limit <= max_export_rows, "Limit must be between 1 and " + std::to_string(max_export_rows));
+  check(get_game_config().players_complete.value_or(false), "Players are not registered, run addplayers with complete first");
+
+  export_page page;
+  export_cursor next = cursor;
+  uint32_t budget = limit;
+  players_t players_table(get_self(), get_self().value);
+  while(next.table != export_done)
+  {
+    bool exhausted = false;
+    if(next.table == export_blends)
+    {
+      blends_t blends_table(get_self(), get_self().value);
+      exhausted = export_rows(blends_table, next, page.rows, budget);
+    }
+    else if(next.table == export_resourcecost)
+    {
+      resourcecost_t resourcecost_table(get_self(), get_self().value);
+      exhausted = export_rows(resourcecost_table, next, page.rows, budget);
+    }
+    else if(next.table == export_orders)
+    {
+      orders_t orders_table(get_self(), get_self().value);
+      exhausted = export_rows(orders_table, next, page.rows, budget);
+    }
+    else if(next.table == export_autoclaim)
+    {
+      autoclaim_t autoclaim_table(get_self(), get_self().value);
+      exhausted = export_rows(autoclaim_table, next, page.rows, budget);
+    }
+    else if(next.table == export_staked)
+    {
+      staked_t staked_table(get_self(), next.scope);
+      exhausted = export_rows(staked_table, next, page.rows, budget);
+    }
+    else if(next.table == export_resources)
+    {
+      resources_t resources_table(get_self(), next.scope);
+      exhausted = export_rows(resources_table, next, page.rows, budget);
+    }
+    else if(next.table == export_ledger)
+    {
+      ledger_t ledger_table(get_self(), next.scope);
+      exhausted = export_rows(ledger_table, next, page.rows, budget);
+    }
+    else if(next.table == export_mined)
+    {
+      mined_t mined_table(get_self(), next.scope);
+      exhausted = export_rows(mined_table, next, page.rows, budget);
+    }
+    else
+      check(false, "Unknown export table");
+
+    if(!exhausted)
+      break;
+
+    next.next_key = 0;
+    if(next.table != export_autoclaim && next.table != export_mined)
+    {
+      ++next.table;
+      continue;
+    }
+
+    // owner scoped tables follow, player by player
+    auto players_table_itr = next.table == export_autoclaim ? std::begin(players_table) : players_table.upper_bound(next.scope);
+    if(players_table_itr == std::end(players_table))
+    {
+      next.table = export_done;
+    }
+    else
+    {
+      next.table = export_staked;
+      next.scope = players_table_itr->owner.value;
+    }
+  }
+
+  if(next.table != export_done)
+    page.next = next;
+
+  return page;
+}
+
+std::map<std::string, float> game::reduce_owner_resources_balance(const name& owner, const std::map<std::string, float>& resources)
+{
+  std::map<std::string, float> balances;
+  resources_t resources_table(get_self(), owner.value);
+
+  for(const auto& map_itr : resources)
+  {
+    const uint64_t& key_id = stringToUint64(map_itr.first);
+    auto resources_table_itr = resources_table.require_find(key_id,
+      ("Could not find balance of " + map_itr.first).c_str());
+    check(resources_table_itr->amount >= map_itr.second, ("Overdrawn balance: " + map_itr.first).c_str());
+
+    if(resources_table_itr->amount == map_itr.second)
+    {
+      resources_table.erase(resources_table_itr);
+      balances[map_itr.first] = 0;
+    }
+    else
+    {
+      resources_table.modify(resources_table_itr, get_self(), [&](auto &new_row)
+      {
+        new_row.amount -= map_itr.second;
+      });
+      balances[map_itr.first] = resources_table_itr->amount;
+    }
+  }
+
+  return balances;
+}
+
+
+game::asset_mdata game::get_mdata(atomicassets::assets_t::const_iterator& assets_itr)
+{
+  GAME_PROFILE_COUNT(mdata_reads);
+  GAME_PROFILE_COUNT(decodes);
+
+  return atomicdata::decode_bound
+  (
+    assets_itr->mutable_serialized_data,
+    get_mdata_layout(assets_itr->collection_name, assets_itr->schema_name)
+  );
+}
+
+const atomicdata::bound_layout<game::asset_mdata>& game::get_mdata_layout(const name& collection_name, const name& schema_name)
+{
+  const auto key = std::make_pair(collection_name.value, schema_name.value);
+  auto mdata_layouts_itr = mdata_layouts.find(key);
+  if(mdata_layouts_itr == std::end(mdata_layouts))
+  {
+    auto schemas = get_schemas(collection_name);
+    auto schema_itr = schemas.require_find(schema_name.value, "Could not find schema");
+
+    mdata_layouts_itr = mdata_layouts.emplace(key, atomicdata::make_bound_layout<asset_mdata>(schema_itr->format)).first;
+  }
+  return mdata_layouts_itr->second;
+}
+
+game::tmplcache_j game::get_template_idata(const int32_t& template_id, const name& collection_name)
+{
+  GAME_PROFILE_COUNT(idata_reads);
+  GAME_PROFILE_COUNT(decodes);
+  auto templates = get_templates(collection_name);
+  auto template_itr = templates.require_find(template_id, "Could not find template");
+
+  auto schemas = get_schemas(collection_name);
+  auto schema_itr = schemas.require_find(template_itr->schema_name.value, "Could not find schema");
+
+  tmplcache_j template_attrs = atomicdata::decode_bound<tmplcache_j>
+  (
+    template_itr->immutable_serialized_data,
+    schema_itr->format
+  );
+  template_attrs.template_id = template_id;
+
+  return template_attrs;
+}
+
+const game::tmplcache_j& game::find_template_attrs(const int32_t& template_id, const name& collection_name)
+{
+  const auto key = std::make_pair(collection_name.value, template_id);
+  auto memo_itr = template_attrs_memo.find(key);
+  if(memo_itr != std::end(template_attrs_memo))
+    return memo_itr->second.first;
+
+  tmplcache_t tmplcache_table(get_self(), collection_name.value);
+  auto tmplcache_table_itr = tmplcache_table.find(template_id);
+  if(tmplcache_table_itr != std::end(tmplcache_table))
+    return template_attrs_memo.emplace(key, std::make_pair(*tmplcache_table_itr, true)).first->second.first;
+
+  return template_attrs_memo.emplace(key, std::make_pair(get_template_idata(template_id, collection_name), false)).first->second.first;
+}
+
+const game::tmplcache_j& game::get_template_attrs(const int32_t& template_id, const name& collection_name)
+{
+  const tmplcache_j& attrs = find_template_attrs(template_id, collection_name);
+
+  bool& stored = template_attrs_memo[std::make_pair(collection_name.value, template_id)].second;
+  if(!stored)
+  {
+    tmplcache_t tmplcache_table(get_self(), collection_name.value);
+    tmplcache_table.emplace(get_self(), [&](auto &new_row)
+    {
+      new_row = attrs;
+    });
+    stored = true;
+  }
+  return attrs;
+}
+
+void game::update_mdata(atomicassets::assets_t::const_iterator& assets_itr, const asset_mdata& new_mdata, const name& owner)
+{
+  send_action
+  (
+    atomicassets::ATOMICASSETS_ACCOUNT,
+    "setassetdata"_n,
+    get_self(),
+    owner,
+    assets_itr->asset_id,
+    atomicdata::bound_map<asset_mdata>{new_mdata}
+  );
+  GAME_PROFILE_COUNT(mdata_writes);
 }
 
 
@@ -0,0 +1,255 @@
+// Native checks of the per-item arena (arena.hpp) and of the undecoded others of typed bindings
+// (atomicbinding.hpp), exits non-zero on the first failed check.
+//
+//   g++ -std=c++17 -O2 -DATOMICDATA_NATIVE -I include tests/arena_test.cpp -o arena_test && ./arena_test
+//
+// Heap use is measured like the WASM allocator sees it: freed memory is not reused within an action,
+// so every byte passed to operator new counts. The claim loop is replayed for a growing number of
+// items, each item decodes mutable data with unbound attributes and packs it for setassetdata.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+
+#include "atomicbinding.hpp"
+
+#define EXPECT(condition) \
+  if(!(condition)) { std::fprintf(stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__, #condition); std::exit(1); }
+
+namespace
+{
+  size_t heap_bytes = 0;
+}
+
+void* operator new(size_t size)
+{
+  heap_bytes += size;
+  if(void* ptr = std::malloc(size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+// collects packed bytes like eosio::datastream<char*>
+struct byte_stream
+{
+  std::string bytes;
+
+  bool write(const void* data, size_t size)
+  {
+    bytes.append(static_cast<const char*>(data), size);
+    return true;
+  }
+};
+
+template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+byte_stream& operator<<(byte_stream& ds, const T& value)
+{
+  ds.write(&value, sizeof(T));
+  return ds;
+}
+
+namespace
+{
+  // same shape as game::asset_mdata
+  struct test_mdata
+  {
+    std::optional<uint8_t>       level;
+    std::optional<uint32_t>      lastClaim;
+    atomicdata::RAW_ATTRIBUTES   others;
+
+    static constexpr auto fields()
+    {
+      return std::make_tuple(
+        atomicdata::bind("level", &test_mdata::level),
+        atomicdata::bind("lastClaim", &test_mdata::lastClaim)
+      );
+    }
+  };
+
+  const std::vector<atomicdata::FORMAT> format =
+  {
+    {"level", "uint8"},
+    {"description_of_the_item", "string"},
+    {"lastClaim", "uint32"},
+    {"tags", "string[]"},
+    {"power", "int16"},
+    {"deltas", "int64[]"},
+    {"ratio", "float"},
+    {"weight", "fixed32"},
+    {"flag", "bool"},
+    {"amounts", "uint64[]"}
+  };
+
+  atomicdata::ATTRIBUTE_MAP attributes()
+  {
+    return {
+      {"level", uint8_t(3)},
+      {"description_of_the_item", std::string("an attribute the game does not bind, longer than any small string")},
+      {"lastClaim", uint32_t(1700000000)},
+      {"tags", atomicdata::string_VEC{"first tag that is long enough to allocate", "second"}},
+      {"power", int16_t(-300)},
+      {"deltas", atomicdata::INT64_VEC{-1, 5000000000, 0}},
+      {"ratio", 1.5f},
+      {"weight", uint32_t(123456)},
+      {"flag", uint8_t(1)},
+      {"amounts", atomicdata::UINT64_VEC{1, 300, 1ull << 40}}
+    };
+  }
+
+  void write_varint(std::string& out, uint64_t number)
+  {
+    byte_stream ds;
+    atomicdata::write_varint(ds, number);
+    out += ds.bytes;
+  }
+
+  // reference packing of an ATOMIC_ATTRIBUTE in its ABI layout
+  void pack_reference(std::string& out, const atomicdata::ATOMIC_ATTRIBUTE& attribute)
+  {
+    write_varint(out, attribute.index());
+    std::visit([&](const auto& value)
+    {
+      using V = std::decay_t<decltype(value)>;
+      auto pack_scalar = [&](const auto& scalar)
+      {
+        using S = std::decay_t<decltype(scalar)>;
+        if constexpr(std::is_same_v<S, std::string>)
+        {
+          write_varint(out, scalar.size());
+          out += scalar;
+        }
+        else
+          out.append(reinterpret_cast<const char*>(&scalar), sizeof(S));
+      };
+
+      if constexpr(atomicdata::is_vector<V>::value)
+      {
+        write_varint(out, value.size());
+        for(const auto& element : value)
+          pack_scalar(element);
+      }
+      else
+        pack_scalar(value);
+    }, attribute);
+  }
+
+  void test_pack_matches_decoded_map()
+  {
+    const std::vector<uint8_t> data = atomicdata::serialize(attributes(), format);
+    const auto layout = atomicdata::make_bound_layout<test_mdata>(format);
+    const atomicdata::ATTRIBUTE_MAP decoded = atomicdata::deserialize(data, format);
+
+    // bound attributes first in fields() order, then the others in format order
+    std::string expected;
+    write_varint(expected, decoded.size());
+    for(const char* name : {"level", "lastClaim"})
+    {
+      write_varint(expected, std::strlen(name));
+      expected += name;
+      pack_reference(expected, decoded.at(name));
+    }
+    for(const auto& line : format)
+    {
+      if(line.name == "level" || line.name == "lastClaim")
+        continue;
+      write_varint(expected, line.name.size());
+      expected += line.name;
+      pack_reference(expected, decoded.at(line.name));
+    }
+
+    arena::scope item_scope;
+    const test_mdata mdata = atomicdata::decode_bound<test_mdata>(data, layout);
+    EXPECT(mdata.level.value() == 3);
+    EXPECT(mdata.lastClaim.value() == 1700000000);
+    EXPECT(mdata.others.size() == format.size() - 2);
+
+    byte_stream packed;
+    packed << atomicdata::bound_map<test_mdata>{mdata};
+    EXPECT(packed.bytes == expected);
+  }
+
+  // bytes passed to operator new by items replayed claim iterations after a first warm-up item
+  size_t claim_heap_bytes(const size_t& items, const bool& use_arena)
+  {
+    const std::vector<uint8_t> data = atomicdata::serialize(attributes(), format);
+    const auto layout = atomicdata::make_bound_layout<test_mdata>(format);
+    byte_stream packed;
+    packed.bytes.reserve(4096);
+
+    size_t bytes = 0;
+    for(size_t item = 0; item <= items; ++item)
+    {
+      if(item == 1)
+        bytes = heap_bytes;
+
+      std::optional<arena::scope> item_scope;
+      if(use_arena)
+        item_scope.emplace();
+      test_mdata mdata = atomicdata::decode_bound<test_mdata>(data, layout);
+      mdata.lastClaim = uint32_t(item);
+      packed.bytes.clear();
+      packed << atomicdata::bound_map<test_mdata>{mdata};
+    }
+    return heap_bytes - bytes;
+  }
+
+  void test_claim_heap_is_flat()
+  {
+    std::printf("items  heap bytes with arena  heap bytes without arena\n");
+    for(const size_t items : {1, 10, 100, 1000})
+    {
+      const size_t with_arena    = claim_heap_bytes(items, true);
+      const size_t without_arena = claim_heap_bytes(items, false);
+      std::printf("%5zu  %21zu  %24zu\n", items, with_arena, without_arena);
+
+      EXPECT(with_arena == 0);
+      EXPECT(without_arena > 0);
+    }
+    std::printf("arena blocks: %zu bytes\n", arena::get_state().reserved);
+    EXPECT(arena::get_state().reserved == arena::block_size);
+  }
+
+  void test_scopes_nest_and_fall_back_to_heap()
+  {
+    EXPECT(arena::get_state().depth == 0);
+    const size_t before = heap_bytes;
+    {
+      std::vector<uint8_t, arena::allocator<uint8_t>> outside(64);
+      EXPECT(!arena::owns(outside.data()));
+      EXPECT(heap_bytes > before);
+
+      arena::scope outer;
+      std::vector<uint8_t, arena::allocator<uint8_t>> first(64);
+      {
+        arena::scope inner;
+        std::vector<uint8_t, arena::allocator<uint8_t>> second(64);
+        EXPECT(arena::owns(second.data()));
+        EXPECT(second.data() >= first.data() + 64);
+      }
+      // inner memory is handed back, outer memory stays
+      std::vector<uint8_t, arena::allocator<uint8_t>> third(64);
+      EXPECT(arena::owns(first.data()));
+      EXPECT(third.data() >= first.data() + 64);
+    }
+    EXPECT(arena::get_state().depth == 0);
+    EXPECT(arena::get_state().current == 0 && arena::get_state().used == 0);
+
+    // larger than a block
+    arena::scope large_scope;
+    std::vector<uint8_t, arena::allocator<uint8_t>> large(arena::block_size * 2);
+    EXPECT(arena::owns(large.data()) && arena::owns(large.data() + large.size() - 1));
+  }
+}
+
+int main()
+{
+  test_pack_matches_decoded_map();
+  test_claim_heap_is_flat();
+  test_scopes_nest_and_fall_back_to_heap();
+  std::printf("arena_test passed\n");
+  return 0;
+}
@@ -0,0 +1,144 @@
+// Native checks of the contract math (gamemath.hpp), exits non-zero on the first failed check.
+//
+//   g++ -std=c++17 -O2 -I include tests/gamemath_test.cpp -o gamemath_test && ./gamemath_test
+//
+// Rewards and upgrade costs are compared with the formulas the contract computed inline before they
+// moved to gamemath.hpp, so a change of the game economy shows up here first.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#include "gamemath.hpp"
+
+#define EXPECT(condition) \
+  if(!(condition)) { std::fprintf(stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__, #condition); std::exit(1); }
+
+namespace baseline
+{
+  // claim_item before gamemath.hpp
+  float reward(const float& miningRate, const uint8_t& current_lvl, const uint8_t& upgrade_percentage, const uint32_t& lastClaim, const uint32_t& time_now)
+  {
+    float miningRate_according2lvl = miningRate;
+    for(uint8_t i = 1; i < current_lvl; ++i)
+        miningRate_according2lvl = miningRate_according2lvl + (miningRate_according2lvl * upgrade_percentage / 100);
+
+    const float& reward = (time_now - lastClaim) * miningRate_according2lvl;
+    return reward;
+  }
+
+  // game::get_upgrading_time before gamemath.hpp
+  int32_t get_upgrading_time(const uint8_t& end_level)
+  {
+    const int32_t increasing_time = 320; // 5.33 min
+    int32_t total_time = 0;
+    int32_t temp_tracker = 0;
+    for(uint8_t i = 2; i <= end_level; ++i)
+    {
+      if(i % 5 == 0)
+      {
+        total_time += (temp_tracker * 5);
+      }
+      else
+      {
+        temp_tracker += increasing_time;
+        total_time += increasing_time;
+      }
+    }
+    return total_time;
+  }
+
+  // resource price of upgrade_item before gamemath.hpp
+  float resource_price(const float& mining_rate, const uint8_t& current_lvl, const uint8_t& new_level, const uint8_t& upgrade_percentage)
+  {
+    float miningRate_according2lvl = mining_rate;
+    for(uint8_t i = 1; i < new_level; ++i)
+      miningRate_according2lvl = miningRate_according2lvl + (miningRate_according2lvl * upgrade_percentage / 100);
+
+    const int32_t& upgrade_time  = get_upgrading_time(new_level) - get_upgrading_time(current_lvl);
+    const float& resource_price = upgrade_time * miningRate_according2lvl;
+    return resource_price;
+  }
+}
+
+namespace
+{
+  const float mining_rates[] = {0.001f, 0.01f, 0.5f, 3.0f, 125.75f};
+
+  bool same_error(const char* error, const char* expected)
+  {
+    return error != nullptr && std::strcmp(error, expected) == 0;
+  }
+
+  void test_swap()
+  {
+    EXPECT(same_error(gamemath::swap_error(0, 100), "Swap amount must be positive"));
+    EXPECT(same_error(gamemath::swap_error(-0.0f, 100), "Swap amount must be positive"));
+    EXPECT(same_error(gamemath::swap_error(-1, 100), "Swap amount must be positive"));
+    EXPECT(same_error(gamemath::swap_error(-1000000, 100), "Swap amount must be positive"));
+    EXPECT(same_error(gamemath::swap_error(NAN, 100), "Swap amount must be positive"));
+
+    EXPECT(same_error(gamemath::swap_error(1, 0), "Swap ratio must be positive"));
+    EXPECT(same_error(gamemath::swap_error(1, -2), "Swap ratio must be positive"));
+    EXPECT(same_error(gamemath::swap_error(1, NAN), "Swap ratio must be positive"));
+
+    EXPECT(same_error(gamemath::swap_error(INFINITY, 100), "Swap amount is too large"));
+    EXPECT(same_error(gamemath::swap_error(1e30f, 100), "Swap amount is too large"));
+
+    // worth less than one token unit
+    EXPECT(same_error(gamemath::swap_error(0.001f, 100), "Swap amount is too small to receive tokens"));
+    EXPECT(same_error(gamemath::swap_error(1, 100000), "Swap amount is too small to receive tokens"));
+
+    EXPECT(gamemath::swap_error(1, 100) == nullptr);
+    EXPECT(gamemath::swap_error(0.01f, 100) == nullptr);
+    EXPECT(gamemath::swap_amount(100, 100) == gamemath::token_precision);
+    EXPECT(gamemath::swap_amount(250, 100) == 25000);
+  }
+
+  void test_upgrading_time()
+  {
+    EXPECT(gamemath::upgrading_time(1) == 0);
+    EXPECT(gamemath::upgrading_time(2) == 320);
+    EXPECT(gamemath::upgrading_time(4) == 960);
+    EXPECT(gamemath::upgrading_time(5) == 5760);
+    // the baseline loop never ends for level 255, its uint8_t counter wraps
+    for(uint32_t level = 1; level < 255; ++level)
+      EXPECT(gamemath::upgrading_time(level) == baseline::get_upgrading_time(level));
+  }
+
+  void test_reward()
+  {
+    EXPECT(gamemath::reward(0.5f, 1, 2, 1000, 1000) == 0);
+    EXPECT(gamemath::reward(0.5f, 1, 2, 2000, 1000) == 0);
+    EXPECT(gamemath::reward(0.5f, 1, 2, 1000, 1100) == 50);
+
+    for(const float& rate : mining_rates)
+      for(uint32_t level = 1; level <= 100; ++level)
+        for(const uint32_t& elapsed : {1u, 60u, 3600u, 86400u, 2592000u})
+          EXPECT(gamemath::reward(rate, level, gamemath::upgrade_percentage, 1700000000, 1700000000 + elapsed)
+            == baseline::reward(rate, level, gamemath::upgrade_percentage, 1700000000, 1700000000 + elapsed));
+  }
+
+  void test_upgrade_cost()
+  {
+    EXPECT(gamemath::upgrade_cost(1, 1, 2, 0) == 320);
+
+    for(const float& rate : mining_rates)
+      for(uint32_t current = 1; current < 60; ++current)
+        for(uint32_t next = current + 1; next <= 60; ++next)
+          EXPECT(gamemath::upgrade_cost(rate, current, next, gamemath::upgrade_percentage)
+            == baseline::resource_price(rate, current, next, gamemath::upgrade_percentage));
+  }
+}
+
+int main()
+{
+  test_swap();
+  test_upgrading_time();
+  test_reward();
+  test_upgrade_cost();
+  std::printf("gamemath_test passed\n");
+  return 0;
+}
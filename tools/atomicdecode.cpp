@@ -0,0 +1,405 @@
+// Bulk decoder for atomicassets serialized data, decodes with the contract's own codec (atomicdata.hpp).
+//
+//   g++ -std=c++17 -O2 -pthread -DATOMICDATA_NATIVE -I include tools/atomicdecode.cpp -o atomicdecode
+//   ./atomicdecode schemas.txt dump.bin out/ [threads]
+//
+// schemas.txt has one schema per line, its index is the line number starting at 0:
+//   <schema_name> <attribute>:<type> <attribute>:<type> ...
+//
+// dump.bin is a sequence of little endian records, e.g. mutable_serialized_data of assets_s rows
+// or immutable_serialized_data of templates_s rows:
+//   uint64 id | uint32 schema index | uint32 size | size bytes of serialized data
+//
+// Every schema attribute is written as its own column file out/<schema>.<attribute>.csv with
+// `id,value` lines, arrays are written as "a;b;c". Records are decoded in chunks by worker
+// threads into buffers that are reused between batches, and written in dump order, so the
+// output does not depend on the number of threads. Records that fail to decode are reported on
+// stderr and skipped.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "atomicdata.hpp"
+
+namespace
+{
+  struct schema
+  {
+    std::string                     name;
+    std::vector<atomicdata::FORMAT> format;
+    uint32_t                        first_column;
+  };
+
+  struct record
+  {
+    uint64_t       id;
+    uint32_t       schema_index;
+    uint32_t       size;
+    const uint8_t* data;
+  };
+
+  // decoded values of one chunk, a csv fragment per column
+  struct chunk_output
+  {
+    std::vector<std::string> columns;
+    std::string              errors;
+    // attributes of the record being decoded, column and value, appended once the whole record decoded
+    std::vector<std::pair<uint32_t, atomicdata::ATOMIC_ATTRIBUTE>> pending;
+  };
+
+  using byte_itr = std::vector<uint8_t>::const_iterator;
+
+  constexpr size_t chunk_records = 8192;
+
+  template <typename V>
+  struct is_vector : std::false_type {};
+
+  template <typename V>
+  struct is_vector<std::vector<V>> : std::true_type {};
+
+  template <typename T>
+  T read_le(const uint8_t* p)
+  {
+    T value = 0;
+    for(size_t i = 0; i < sizeof(T); ++i)
+      value |= T(p[i]) << (8 * i);
+    return value;
+  }
+
+  bool load_schemas(const char* path, std::vector<schema>& schemas, uint32_t& columns)
+  {
+    std::ifstream in(path);
+    if(!in)
+      return false;
+
+    columns = 0;
+    std::string line;
+    while(std::getline(in, line))
+    {
+      std::istringstream fields(line);
+      schema s;
+      fields >> s.name;
+      s.first_column = columns;
+
+      std::string attribute;
+      while(fields >> attribute)
+      {
+        const size_t colon = attribute.find(':');
+        if(colon == std::string::npos)
+        {
+          std::fprintf(stderr, "schema %s: expected <attribute>:<type>, got %s\n", s.name.c_str(), attribute.c_str());
+          return false;
+        }
+        s.format.push_back({attribute.substr(0, colon), attribute.substr(colon + 1)});
+        ++columns;
+      }
+      schemas.push_back(std::move(s));
+    }
+    return true;
+  }
+
+  void append_scalar(std::string& out, const std::string& value)
+  {
+    out += '"';
+    for(const char c : value)
+    {
+      if(c == '"')
+        out += '"';
+      out += c;
+    }
+    out += '"';
+  }
+
+  template <typename V>
+  void append_scalar(std::string& out, const V& value)
+  {
+    char text[32];
+    if constexpr(std::is_same_v<V, float>)
+      std::snprintf(text, sizeof(text), "%.9g", value);
+    else if constexpr(std::is_same_v<V, double>)
+      std::snprintf(text, sizeof(text), "%.17g", value);
+    else if constexpr(std::is_signed_v<V>)
+      std::snprintf(text, sizeof(text), "%lld", (long long) value);
+    else
+      std::snprintf(text, sizeof(text), "%llu", (unsigned long long) value);
+    out += text;
+  }
+
+  void append_value(std::string& out, const atomicdata::ATOMIC_ATTRIBUTE& attribute)
+  {
+    std::visit([&](const auto& value)
+    {
+      using V = std::decay_t<decltype(value)>;
+      if constexpr(is_vector<V>::value)
+      {
+        std::string joined;
+        for(size_t i = 0; i < value.size(); ++i)
+        {
+          if(i > 0)
+            joined += ';';
+          if constexpr(std::is_same_v<typename V::value_type, std::string>)
+            joined += value[i];
+          else
+            append_scalar(joined, value[i]);
+        }
+        append_scalar(out, joined);
+      }
+      else
+      {
+        append_scalar(out, value);
+      }
+    }, attribute);
+  }
+
+  uint64_t read_varint(byte_itr& itr, const byte_itr& end)
+  {
+    uint64_t number = 0;
+    for(uint32_t shift = 0; itr < end; shift += 7)
+    {
+      const uint8_t byte = *itr++;
+      eosio::check(shift < 64, "varint is too long");
+      number |= uint64_t(byte & 0x7f) << shift;
+      if(byte < 128)
+        return number;
+    }
+    eosio::check(false, "varint runs past the end of the data");
+    return 0;
+  }
+
+  void skip_bytes(byte_itr& itr, const byte_itr& end, const uint64_t& length)
+  {
+    eosio::check(length <= uint64_t(end - itr), "attribute runs past the end of the data");
+    itr += length;
+  }
+
+  // walks one attribute like atomicdata::deserialize_attribute but checks every length against the
+  // data left, the codec trusts lengths and would read past the buffer on a corrupt record
+  void check_attribute(const std::string& type, byte_itr& itr, const byte_itr& end)
+  {
+    if(type.size() > 2 && type.compare(type.size() - 2, 2, "[]") == 0)
+    {
+      const uint64_t array_length = read_varint(itr, end);
+      // every element takes at least one byte
+      eosio::check(array_length <= uint64_t(end - itr), "array runs past the end of the data");
+      const std::string base_type = type.substr(0, type.size() - 2);
+      for(uint64_t i = 0; i < array_length; ++i)
+        check_attribute(base_type, itr, end);
+      return;
+    }
+
+    if(type == "int8" || type == "int16" || type == "int32" || type == "int64"
+      || type == "uint8" || type == "uint16" || type == "uint32" || type == "uint64")
+      read_varint(itr, end);
+    else if(type == "fixed8" || type == "bool" || type == "byte")
+      skip_bytes(itr, end, 1);
+    else if(type == "fixed16")
+      skip_bytes(itr, end, 2);
+    else if(type == "fixed32" || type == "float")
+      skip_bytes(itr, end, 4);
+    else if(type == "fixed64" || type == "double")
+      skip_bytes(itr, end, 8);
+    else if(type == "string" || type == "image" || type == "ipfs")
+      skip_bytes(itr, end, read_varint(itr, end));
+    else
+      eosio::check(false, "No type could be matched - " + type);
+  }
+
+  // same loop as atomicdata::deserialize, values go to their columns instead of an ATTRIBUTE_MAP
+  void decode_record(const record& r, const schema& s, std::vector<uint8_t>& buffer, chunk_output& output)
+  {
+    buffer.assign(r.data, r.data + r.size);
+    const auto end = buffer.cend();
+
+    output.pending.clear();
+    auto itr = buffer.cbegin();
+    while(itr < end)
+    {
+      const uint64_t identifier = read_varint(itr, end);
+      eosio::check(identifier >= atomicdata::RESERVED && identifier - atomicdata::RESERVED < s.format.size(),
+        "attribute identifier out of range");
+      const uint64_t line = identifier - atomicdata::RESERVED;
+
+      auto checked = itr;
+      check_attribute(s.format[line].type, checked, end);
+      output.pending.emplace_back(s.first_column + line, atomicdata::deserialize_attribute(s.format[line].type, itr));
+    }
+
+    // a record that fails above leaves nothing in the columns
+    char id_text[24];
+    std::snprintf(id_text, sizeof(id_text), "%llu,", (unsigned long long) r.id);
+    for(const auto& value : output.pending)
+    {
+      std::string& column = output.columns[value.first];
+      column += id_text;
+      append_value(column, value.second);
+      column += '\n';
+    }
+  }
+
+  void decode_chunk(const std::vector<record>& records, const size_t& first, const size_t& last,
+    const std::vector<schema>& schemas, std::vector<uint8_t>& buffer, chunk_output& output)
+  {
+    for(auto& column : output.columns)
+      column.clear();
+    output.errors.clear();
+
+    for(size_t i = first; i < last; ++i)
+    {
+      const record& r = records[i];
+      try
+      {
+        eosio::check(r.schema_index < schemas.size(), "unknown schema index");
+        decode_record(r, schemas[r.schema_index], buffer, output);
+      }
+      catch(const std::exception& e)
+      {
+        output.errors += "record " + std::to_string(r.id) + ": " + e.what() + "\n";
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  if(argc < 4)
+  {
+    std::fprintf(stderr, "usage: %s <schemas.txt> <dump.bin> <out dir> [threads]\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<schema> schemas;
+  uint32_t column_count = 0;
+  if(!load_schemas(argv[1], schemas, column_count))
+  {
+    std::fprintf(stderr, "can not read schemas %s\n", argv[1]);
+    return 1;
+  }
+
+  uint32_t threads = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : std::thread::hardware_concurrency();
+  if(threads == 0)
+    threads = 1;
+
+  const int fd = open(argv[2], O_RDONLY);
+  struct stat st;
+  if(fd < 0 || fstat(fd, &st) != 0)
+  {
+    std::fprintf(stderr, "can not open dump %s\n", argv[2]);
+    return 1;
+  }
+  const size_t file_size = st.st_size;
+  const uint8_t* dump = nullptr;
+  if(file_size > 0)
+  {
+    void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(mapped == MAP_FAILED)
+    {
+      std::fprintf(stderr, "can not map dump %s\n", argv[2]);
+      return 1;
+    }
+    dump = static_cast<const uint8_t*>(mapped);
+    madvise(mapped, file_size, MADV_SEQUENTIAL);
+  }
+
+  // index records, the headers are fixed size so this pass is cheap
+  std::vector<record> records;
+  for(size_t offset = 0; offset < file_size;)
+  {
+    if(file_size - offset < 16)
+    {
+      std::fprintf(stderr, "truncated record header at offset %zu\n", offset);
+      return 1;
+    }
+    record r;
+    r.id           = read_le<uint64_t>(dump + offset);
+    r.schema_index = read_le<uint32_t>(dump + offset + 8);
+    r.size         = read_le<uint32_t>(dump + offset + 12);
+    offset += 16;
+    if(file_size - offset < r.size)
+    {
+      std::fprintf(stderr, "truncated record %llu at offset %zu\n", (unsigned long long) r.id, offset);
+      return 1;
+    }
+    r.data = dump + offset;
+    offset += r.size;
+    records.push_back(r);
+  }
+
+  std::vector<FILE*> files(column_count, nullptr);
+  for(const auto& s : schemas)
+  {
+    for(size_t i = 0; i < s.format.size(); ++i)
+    {
+      const std::string path = std::string(argv[3]) + "/" + s.name + "." + s.format[i].name + ".csv";
+      FILE* file = std::fopen(path.c_str(), "w");
+      if(file == nullptr)
+      {
+        std::fprintf(stderr, "can not create %s\n", path.c_str());
+        return 1;
+      }
+      std::fputs("id,value\n", file);
+      files[s.first_column + i] = file;
+    }
+  }
+
+  // decode a batch of chunks in parallel, then write it in order; outputs and buffers are reused
+  const size_t chunks = (records.size() + chunk_records - 1) / chunk_records;
+  const size_t batch_chunks = size_t(threads) * 4;
+  std::vector<chunk_output> outputs(std::min(batch_chunks, chunks));
+  for(auto& output : outputs)
+    output.columns.resize(column_count);
+  std::vector<std::vector<uint8_t>> buffers(threads);
+
+  uint64_t failed = 0;
+  for(size_t batch_first = 0; batch_first < chunks; batch_first += batch_chunks)
+  {
+    const size_t batch_last = std::min(batch_first + batch_chunks, chunks);
+    std::atomic<size_t> next_chunk{batch_first};
+
+    std::vector<std::thread> workers;
+    for(uint32_t t = 0; t < threads; ++t)
+    {
+      workers.emplace_back([&, t]()
+      {
+        for(size_t chunk = next_chunk++; chunk < batch_last; chunk = next_chunk++)
+        {
+          const size_t first = chunk * chunk_records;
+          const size_t last  = std::min(first + chunk_records, records.size());
+          decode_chunk(records, first, last, schemas, buffers[t], outputs[chunk - batch_first]);
+        }
+      });
+    }
+    for(auto& worker : workers)
+      worker.join();
+
+    for(size_t chunk = batch_first; chunk < batch_last; ++chunk)
+    {
+      const chunk_output& output = outputs[chunk - batch_first];
+      for(uint32_t c = 0; c < column_count; ++c)
+        std::fwrite(output.columns[c].data(), 1, output.columns[c].size(), files[c]);
+      if(!output.errors.empty())
+      {
+        std::fputs(output.errors.c_str(), stderr);
+        failed += std::count(output.errors.begin(), output.errors.end(), '\n');
+      }
+    }
+  }
+
+  for(FILE* file : files)
+    std::fclose(file);
+  if(dump != nullptr)
+    munmap(const_cast<uint8_t*>(dump), file_size);
+  close(fd);
+
+  std::fprintf(stderr, "decoded %zu records, %llu failed\n", records.size() - failed, (unsigned long long) failed);
+  return failed == 0 ? 0 : 2;
+}
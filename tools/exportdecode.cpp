@@ -0,0 +1,193 @@
+// Decoder of exportstate pages into a snapshot file that native tools can mmap.
+//
+//   g++ -std=c++17 -O2 tools/exportdecode.cpp -o exportdecode
+//   ./exportdecode pages.hex snapshot.bin
+//
+// pages.hex has one exportstate return value per line as hex, e.g. return_value_hex_data of the
+// action trace of a read-only transaction, pages in the order they were requested.
+//
+// snapshot.bin is a sequence of little endian records, one per exported row:
+//   uint8 table | uint64 scope | uint64 key | uint32 size | size bytes of the row as packed in the table
+// table is game::export_table: 0 blends, 1 resourcecost, 2 orders, 3 autoclaim, 4 staked,
+// 5 resources, 6 ledger, 7 mined, scope is 0 for the first four. Rows keep the order of the pages.
+//
+// The cursor to request the next page with is printed as `<table> <scope> <next_key>` after the
+// last page, or `done` when the last page ended the export.
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  struct reader
+  {
+    const std::vector<uint8_t>& data;
+    size_t                      offset;
+    bool                        failed;
+
+    bool take(const size_t& size)
+    {
+      if(!failed && data.size() - offset < size)
+        failed = true;
+      return !failed;
+    }
+
+    uint64_t read_le(const size_t& size)
+    {
+      uint64_t value = 0;
+      if(!take(size))
+        return 0;
+      for(size_t i = 0; i < size; ++i)
+        value |= uint64_t(data[offset + i]) << (8 * i);
+      offset += size;
+      return value;
+    }
+
+    uint32_t read_varuint32()
+    {
+      uint64_t value = 0;
+      for(uint32_t shift = 0; shift < 35; shift += 7)
+      {
+        if(!take(1))
+          return 0;
+        const uint8_t byte = data[offset++];
+        value |= uint64_t(byte & 0x7f) << shift;
+        if(byte < 128)
+          return value <= UINT32_MAX ? uint32_t(value) : (failed = true, 0);
+      }
+      failed = true;
+      return 0;
+    }
+  };
+
+  struct export_cursor
+  {
+    uint8_t  table;
+    uint64_t scope;
+    uint64_t next_key;
+  };
+
+  bool hex_to_bytes(const std::string& hex, std::vector<uint8_t>& bytes)
+  {
+    if(hex.size() % 2 != 0)
+      return false;
+
+    bytes.resize(hex.size() / 2);
+    for(size_t i = 0; i < bytes.size(); ++i)
+    {
+      uint8_t byte = 0;
+      for(size_t j = 0; j < 2; ++j)
+      {
+        const char c = hex[i * 2 + j];
+        byte <<= 4;
+        if(c >= '0' && c <= '9')      byte |= c - '0';
+        else if(c >= 'a' && c <= 'f') byte |= c - 'a' + 10;
+        else if(c >= 'A' && c <= 'F') byte |= c - 'A' + 10;
+        else return false;
+      }
+      bytes[i] = byte;
+    }
+    return true;
+  }
+
+  void write_le(std::string& out, const uint64_t& value, const size_t& size)
+  {
+    for(size_t i = 0; i < size; ++i)
+      out += char(value >> (8 * i));
+  }
+
+  // appends the rows of one packed export_page to out, next is set from the page cursor
+  bool decode_page(const std::vector<uint8_t>& page, std::string& out, uint64_t& rows, bool& has_next, export_cursor& next)
+  {
+    reader r{page, 0, false};
+
+    const uint32_t row_count = r.read_varuint32();
+    for(uint32_t i = 0; i < row_count && !r.failed; ++i)
+    {
+      const uint8_t  table = r.read_le(1);
+      const uint64_t scope = r.read_le(8);
+      const uint64_t key   = r.read_le(8);
+      const uint32_t size  = r.read_varuint32();
+      if(!r.take(size))
+        break;
+
+      write_le(out, table, 1);
+      write_le(out, scope, 8);
+      write_le(out, key, 8);
+      write_le(out, size, 4);
+      out.append(reinterpret_cast<const char*>(page.data() + r.offset), size);
+      r.offset += size;
+      ++rows;
+    }
+
+    has_next = r.read_le(1) != 0;
+    if(has_next)
+    {
+      next.table    = r.read_le(1);
+      next.scope    = r.read_le(8);
+      next.next_key = r.read_le(8);
+    }
+    return !r.failed && r.offset == page.size();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  if(argc < 3)
+  {
+    std::fprintf(stderr, "usage: %s pages.hex snapshot.bin\n", argv[0]);
+    return 1;
+  }
+
+  std::ifstream pages(argv[1]);
+  if(!pages)
+  {
+    std::fprintf(stderr, "can not read pages %s\n", argv[1]);
+    return 1;
+  }
+
+  FILE* snapshot = std::fopen(argv[2], "wb");
+  if(snapshot == nullptr)
+  {
+    std::fprintf(stderr, "can not create %s\n", argv[2]);
+    return 1;
+  }
+
+  // page and output buffers are reused between pages
+  std::string line;
+  std::vector<uint8_t> page;
+  std::string out;
+  uint64_t rows = 0;
+  uint64_t page_count = 0;
+  bool has_next = true;
+  export_cursor next{};
+  for(size_t line_number = 1; std::getline(pages, line); ++line_number)
+  {
+    if(!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if(line.empty())
+      continue;
+
+    out.clear();
+    if(!hex_to_bytes(line, page) || !decode_page(page, out, rows, has_next, next))
+    {
+      std::fprintf(stderr, "malformed page on line %zu\n", line_number);
+      std::fclose(snapshot);
+      return 2;
+    }
+    std::fwrite(out.data(), 1, out.size(), snapshot);
+    ++page_count;
+  }
+  std::fclose(snapshot);
+
+  if(has_next && page_count > 0)
+    std::printf("%u %llu %llu\n", unsigned(next.table), (unsigned long long) next.scope, (unsigned long long) next.next_key);
+  else if(page_count > 0)
+    std::printf("done\n");
+
+  std::fprintf(stderr, "decoded %llu pages, %llu rows\n", (unsigned long long) page_count, (unsigned long long) rows);
+  return 0;
+}
@@ -0,0 +1,223 @@
+// Native economy simulator, plays out virtual players with the contract's own math (gamemath.hpp).
+//
+//   g++ -std=c++17 -O2 -pthread -I include tools/simulator.cpp -o simulator
+//   ./simulator --players 1000000 --days 90 --seed 1 --mining-rate 0.01 --ratio 100 > curves.csv
+//
+// Every player owns one item and, on each day it plays, claims, then upgrades when it can afford
+// the next level or swaps part of its balance for tokens. Players run in fixed chunks pulled by
+// worker threads from a shared counter, chunk results are summed in chunk order, so the output
+// depends only on the seed and parameters, not on the number of threads.
+//
+// Output is one CSV row per day: resources mined, spent on upgrades, swapped, tokens minted,
+// resources held by players and the average item level.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gamemath.hpp"
+
+namespace
+{
+  struct params
+  {
+    uint64_t players       = 100000;
+    uint32_t days          = 30;
+    uint64_t seed          = 1;
+    uint32_t threads       = std::thread::hardware_concurrency();
+    float    mining_rate   = 0.01f;  // template miningRate, resources per second at level 1
+    uint8_t  max_level     = 20;     // template maxLevel
+    uint8_t  upgrade_pct   = gamemath::upgrade_percentage;
+    float    ratio         = 100.0f; // setratio, resources per token
+    double   play_chance   = 0.6;    // chance a player plays on a given day
+    double   swap_chance   = 0.3;    // chance a playing player swaps instead of saving
+    double   swap_share    = 0.5;    // part of the balance swapped
+  };
+
+  struct day_totals
+  {
+    double   mined    = 0;
+    double   upgrades = 0;
+    double   swapped  = 0;
+    int64_t  tokens   = 0;
+    double   held     = 0;
+    uint64_t levels   = 0;
+    uint64_t active   = 0;
+
+    void add(const day_totals& other)
+    {
+      mined    += other.mined;
+      upgrades += other.upgrades;
+      swapped  += other.swapped;
+      tokens   += other.tokens;
+      held     += other.held;
+      levels   += other.levels;
+      active   += other.active;
+    }
+  };
+
+  struct player
+  {
+    uint8_t  level     = 1;
+    uint32_t lastClaim = 0;
+    float    balance   = 0;
+  };
+
+  // splitmix64, a seekable generator keeps every player's stream independent of scheduling
+  struct rng
+  {
+    uint64_t state;
+
+    uint64_t next()
+    {
+      uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+  };
+
+  constexpr uint64_t chunk_size  = 4096;
+  constexpr uint32_t day_seconds = 86400;
+
+  void simulate_chunk(const params& p, const uint64_t& first, const uint64_t& last, std::vector<day_totals>& days)
+  {
+    for(uint64_t id = first; id < last; ++id)
+    {
+      rng random{p.seed ^ (id * 0xd1b54a32d192ed03ULL)};
+      player pl;
+
+      for(uint32_t day = 0; day < p.days; ++day)
+      {
+        day_totals& totals = days[day];
+        const uint32_t day_start = day * day_seconds;
+
+        if(random.uniform() < p.play_chance)
+        {
+          ++totals.active;
+          const uint32_t time_now = day_start + static_cast<uint32_t>(random.uniform() * day_seconds);
+
+          // claim
+          const float reward = gamemath::reward(p.mining_rate, pl.level, p.upgrade_pct, pl.lastClaim, time_now);
+          if(time_now > pl.lastClaim)
+            pl.lastClaim = time_now;
+          pl.balance   += reward;
+          totals.mined += reward;
+
+          // upgrade one level when affordable and the item is not upgrading, else maybe swap
+          const uint8_t next_level = pl.level + 1;
+          const float cost = pl.level < p.max_level
+            ? gamemath::upgrade_cost(p.mining_rate, pl.level, next_level, p.upgrade_pct)
+            : 0;
+
+          if(pl.level < p.max_level && pl.balance >= cost && pl.lastClaim <= time_now)
+          {
+            pl.balance      -= cost;
+            totals.upgrades += cost;
+            pl.lastClaim     = time_now + gamemath::upgrade_time(pl.level, next_level);
+            pl.level         = next_level;
+          }
+          else if(random.uniform() < p.swap_chance && pl.balance > 0)
+          {
+            const float amount2swap = pl.balance * p.swap_share;
+            pl.balance     -= amount2swap;
+            totals.swapped += amount2swap;
+            totals.tokens  += gamemath::swap_amount(amount2swap, p.ratio);
+          }
+        }
+
+        totals.held   += pl.balance;
+        totals.levels += pl.level;
+      }
+    }
+  }
+
+  bool parse_args(int argc, char** argv, params& p)
+  {
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+      const std::string key = argv[i];
+      const char* value = argv[i + 1];
+
+      if(key == "--players")          p.players     = std::strtoull(value, nullptr, 10);
+      else if(key == "--days")        p.days        = std::strtoul(value, nullptr, 10);
+      else if(key == "--seed")        p.seed        = std::strtoull(value, nullptr, 10);
+      else if(key == "--threads")     p.threads     = std::strtoul(value, nullptr, 10);
+      else if(key == "--mining-rate") p.mining_rate = std::strtof(value, nullptr);
+      else if(key == "--max-level")   p.max_level   = std::strtoul(value, nullptr, 10);
+      else if(key == "--upgrade-pct") p.upgrade_pct = std::strtoul(value, nullptr, 10);
+      else if(key == "--ratio")       p.ratio       = std::strtof(value, nullptr);
+      else if(key == "--play")        p.play_chance = std::strtod(value, nullptr);
+      else if(key == "--swap")        p.swap_chance = std::strtod(value, nullptr);
+      else if(key == "--swap-share")  p.swap_share  = std::strtod(value, nullptr);
+      else
+      {
+        std::fprintf(stderr, "unknown option %s\n", key.c_str());
+        return false;
+      }
+    }
+
+    if(p.threads == 0)
+      p.threads = 1;
+    if(p.ratio <= 0)
+    {
+      std::fprintf(stderr, "ratio must be positive\n");
+      return false;
+    }
+    return true;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  params p;
+  if(!parse_args(argc, argv, p))
+    return 1;
+
+  const uint64_t chunks = (p.players + chunk_size - 1) / chunk_size;
+  std::vector<std::vector<day_totals>> chunk_days(chunks, std::vector<day_totals>(p.days));
+  std::atomic<uint64_t> next_chunk{0};
+
+  std::vector<std::thread> workers;
+  for(uint32_t t = 0; t < p.threads; ++t)
+  {
+    workers.emplace_back([&]()
+    {
+      for(uint64_t chunk = next_chunk++; chunk < chunks; chunk = next_chunk++)
+      {
+        const uint64_t first = chunk * chunk_size;
+        const uint64_t last  = std::min(first + chunk_size, p.players);
+        simulate_chunk(p, first, last, chunk_days[chunk]);
+      }
+    });
+  }
+  for(auto& worker : workers)
+    worker.join();
+
+  std::printf("day,active,mined,upgrades,swapped,tokens,held,avg_level\n");
+  for(uint32_t day = 0; day < p.days; ++day)
+  {
+    day_totals totals;
+    for(const auto& days : chunk_days)
+      totals.add(days[day]);
+
+    std::printf("%u,%llu,%.4f,%.4f,%.4f,%lld.%04lld,%.4f,%.3f\n",
+      day + 1,
+      (unsigned long long) totals.active,
+      totals.mined,
+      totals.upgrades,
+      totals.swapped,
+      (long long) (totals.tokens / gamemath::token_precision),
+      (long long) (totals.tokens % gamemath::token_precision),
+      totals.held,
+      p.players ? double(totals.levels) / p.players : 0.0);
+  }
+
+  return 0;
+}